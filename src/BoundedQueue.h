@@ -0,0 +1,114 @@
+/**
+ * @file BoundedQueue.h
+ * @details 有界无锁队列，多生产者多消费者，实现参考 Dmitry Vyukov 的 bounded MPMC queue
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief 有界无锁队列
+ * @details 容量在构造时确定（向上取整为 2 的幂），入队/出队均不加锁，
+ *          每个槽位用一个序号来区分 "可写"/"可读" 状态
+ * @note 队列满时 tryPush 返回 false, 是否等待由调用者决定
+ */
+template <class T>
+class BoundedQueue {
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 队列容量，至少为 2
+     */
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * @brief 尝试入队
+     * @return 队列已满时返回 false, 此时 value 不会被移动
+     */
+    bool tryPush(T &&value) {
+        Cell *cell;
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 尝试出队
+     * @return 队列为空时返回 false
+     */
+    bool tryPop(T &value) {
+        Cell *cell;
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 队列是否为空
+     * @note 并发情况下只是一个近似值
+     */
+    bool empty() const {
+        return enqueue_pos.load(std::memory_order_acquire) ==
+               dequeue_pos.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 队列容量
+     */
+    size_t capacity() const { return mask + 1; }
+
+private:
+    // 避免生产者和消费者的计数器落在同一个缓存行上
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos{0};
+    alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos{0};
+};
@@ -9,6 +9,10 @@
 #include "Store.h"
 #include "backpack.h"
 #include "Scene.h"
+#include "World.h"
+#include "LogSink.h"
+#include "FlightRecorder.h"
+#include "Log.h"
 #include <iostream>
 #include <fstream>
 #include <regex>
@@ -24,8 +28,9 @@ Controller::Controller(
     const std::filesystem::path &root_dir):
     level(level),
     log_dir(log_dir),
-    root_dir(root_dir) {
-    // 构造函数
+    root_dir(root_dir),
+    log_sink(std::make_unique<LogSink>(log_dir)) {
+    log_threshold.store(level == LogLevel::DEBUG ? LogLevel::DEBUG : LogLevel::INFO);
 }
 
 std::shared_ptr<Controller> Controller::getInstance(const LogLevel &level, const std::filesystem::path &log_dir, const std::filesystem::path &root_dir)
@@ -35,11 +40,11 @@ std::shared_ptr<Controller> Controller::getInstance(const LogLevel &level, const
 }
 
 void Controller::log(const LogLevel& level, const std::string& msg) {
-    std::ofstream debug_log(log_dir / DEBUG_FILE, std::ios::app);
-    std::ofstream info_log(log_dir / INFO_FILE, std::ios::app);
-    std::ofstream warn_log(log_dir / WARN_FILE, std::ios::app);
-    std::ofstream error_log(log_dir / ERROR_FILE, std::ios::app);
-    if (view != nullptr) {
+    // 后台线程（例如预加载地图）的日志只写入文件
+    const bool on_main = std::this_thread::get_id() == main_thread;
+    FlightRecorder::getInstance().record(FlightRecorder::Kind::LOG, static_cast<int>(level),
+                                         on_main && map ? map->getPos() : Position(-1, -1), -1, 0, msg);
+    if (on_main && view != nullptr) {
         Rgb rgb_color = {0 , 0, 0};
         switch (level) {
             case LogLevel::ERR:
@@ -56,31 +61,43 @@ void Controller::log(const LogLevel& level, const std::string& msg) {
                 if(this->level == LogLevel::DEBUG) view->printLog(msg, "", rgb_color);
                 break;
         }
-    } else {
-        error_log << "未初始化 View 下调用 View::printLog" << std::endl;
+    } else if (on_main) {
+        log_sink->write(LogSink::ERROR_LOG, "未初始化 View 下调用 View::printLog");
     }
+    uint8_t targets = LogSink::DEBUG_LOG;
     if (this->level == LogLevel::INFO && level != LogLevel::DEBUG)
-        info_log << msg << std::endl;
+        targets |= LogSink::INFO_LOG;
     if (this->level == LogLevel::WARN && level != LogLevel::INFO && level != LogLevel::DEBUG)
-        warn_log << msg << std::endl;
+        targets |= LogSink::WARN_LOG;
     if (level == LogLevel::ERR)
-        error_log << msg << std::endl;
-    debug_log << msg << std::endl;
+        targets |= LogSink::ERROR_LOG;
+    log_sink->write(targets, msg);
+}
+
+void Controller::flushLogs() {
+    log_sink->flush();
 }
 
 Message Controller::init() {
     protagonist = std::make_shared<Protagonist>();
-    log(LogLevel::DEBUG, "Init: Pro");
+    GAME_LOG(DEBUG, "Init: Pro");
     backpack = std::make_shared<Backpack>();
-    log(LogLevel::DEBUG, "Init: back");
-    input = std::make_shared<InputHandler>();
-    log(LogLevel::DEBUG, "Init: input");
+    GAME_LOG(DEBUG, "Init: back");
+    if (input == nullptr)
+        input = std::make_shared<InputHandler>();
+    GAME_LOG(DEBUG, "Init: input");
     view = View::getInstance();
-    log(LogLevel::DEBUG, "Init view");
-    scene = std::make_shared<Scene>();
-    log(LogLevel::DEBUG, "Init scene");
+    // 等待玩家输入之前输出这段时间内积攒的画面
+    input->setIdleHook([this]() {
+        if (view)
+            view->present();
+    });
+    GAME_LOG(DEBUG, "Init view");
+    world = std::make_shared<World>(root_dir / ".config" / "scenes.json", true);
+    scene = world->getScene("Canteen");
+    GAME_LOG(DEBUG, "Init scene");
     store = std::make_shared<Store>();
-    log(LogLevel::DEBUG, "Init final_exam");
+    GAME_LOG(DEBUG, "Init final_exam");
     final_exam = std::make_shared<FinalExam>();
 
     Message msg {"Init Success!", 0};
@@ -125,7 +142,8 @@ Message Controller::load(std::string username) {
         ifile.close();
         msg = Message("Load Success!", 0);
     }
-    map=std::make_shared<Map>(map_filename);
+    map = world->getMap(map_filename);
+    world->prefetchNeighbours(std::filesystem::path(map_filename).stem().string());
     view->reDraw();
     return msg;
 }
@@ -192,6 +210,13 @@ Message Controller::getEvent(EventType &event_type)
             continue;
         }
 
+        // 输入已关闭，按 quit 处理
+        else if (ch == -1)
+        {
+            cmd = "quit";
+            break;
+        }
+
         // Unexpect input
         else if (ch == 0 || ch == 27)
         {
@@ -206,7 +231,7 @@ Message Controller::getEvent(EventType &event_type)
         view->printCmd(ss.str());
     }
     view = View::getInstance();
-    log(LogLevel::DEBUG, "Get event: " + cmd);
+    GAME_LOG(DEBUG, "Get event: " + cmd);
     // 处理cmd
     if (cmd == "move")
     {
@@ -235,6 +260,7 @@ Message Controller::getEvent(EventType &event_type)
     else if (cmd == "quit")
     {
         event_type = EventType::QUIT;
+        view->present();
         return {"正常退出", 0};
     }
     else if (cmd == "store")
@@ -253,18 +279,39 @@ Message Controller::getEvent(EventType &event_type)
     {
         event_type = EventType::EXAM;
     }
+    else if (cmd == "dump")
+    {
+        event_type = EventType::DUMP;
+    }
+    else if (cmd.rfind("goto ", 0) == 0)
+    {
+        // goto <exit|npc> <id>
+        std::stringstream args(cmd.substr(5));
+        std::string target;
+        goto_id = -1;
+        args >> target >> goto_id;
+        goto_type = target == "npc" ? 0 : target == "exit" ? 2 : -1;
+        if (args.fail() || !args.eof())
+            goto_type = -1;
+        event_type = EventType::GOTO;
+    }
     else
     {
         view = View::getInstance();
         view->printQuestion("", "Enter \"help\" to get help.", "", Rgb(255, 255, 0));
         event_type = EventType::NONE;
     }
-    return handleEvent(event_type);
+    // 一个事件中的所有绘制合并成一帧输出
+    Message msg = handleEvent(event_type);
+    view->present();
+    return msg;
 }
 
 Message Controller::handleEvent(EventType &event_type)
 {
     static int NPCid = -1;
+    FlightRecorder::getInstance().record(FlightRecorder::Kind::EVENT, static_cast<int>(event_type),
+                                         map ? map->getPos() : Position(-1, -1), NPCid);
     switch (event_type)
     {
     case EventType::MOVE:
@@ -275,45 +322,62 @@ Message Controller::handleEvent(EventType &event_type)
         view->printQuestion("", "按下ESC键退出移动模式。", "", Rgb(255, 255, 0));
         while ((ch = input->waitKeyDown()) != 10)
         {
+            if (ch == 27)
+                return Message("Escape key pressed!", 0);
+            if (ch == -1)
+                return Message("Input closed!", -1);
+
+            // 按住或粘贴时积压的按键合并成一批，整批只重绘一次
+            std::vector<int> keys = input->drainKeys();
+            keys.insert(keys.begin(), ch);
             Position last_pos = map->getPos();
-            switch (ch)
+            event_type = EventType::NONE;
+            size_t i = 0;
+            for (; i < keys.size(); ++i)
             {
-            case 'w':
-                map->moveProtagonist(0, event_type, NPCid);
-                log(LogLevel::DEBUG, "NPCid: " + std::to_string(NPCid));
-                break;
-            case 'd':
-                map->moveProtagonist(1, event_type, NPCid);
-                log(LogLevel::DEBUG, "NPCid: " + std::to_string(NPCid));
-                break;
-            case 's':
-                map->moveProtagonist(2, event_type, NPCid);
-                log(LogLevel::DEBUG, "NPCid: " + std::to_string(NPCid));
-                break;
-            case 'a':
-                map->moveProtagonist(3, event_type, NPCid);
-                log(LogLevel::DEBUG, "NPCid: " + std::to_string(NPCid));
-                break;
-            case 27:
-                return Message("Escape key pressed!", 0);
+                // Enter/ESC 留给外层循环处理
+                if (keys[i] == 10 || keys[i] == 27 || keys[i] == -1)
+                    break;
+                int direction = -1;
+                switch (keys[i])
+                {
+                case 'w': direction = 0; break;
+                case 'd': direction = 1; break;
+                case 's': direction = 2; break;
+                case 'a': direction = 3; break;
+                }
+                if (direction == -1)
+                    continue;
+                map->moveProtagonist(direction, event_type, NPCid);
+                GAME_LOG(DEBUG, "NPCid: " + std::to_string(NPCid));
+                FlightRecorder::getInstance().record(FlightRecorder::Kind::MOVE, static_cast<int>(event_type),
+                                                     map->getPos(), NPCid, keys[i]);
+                // 抵达出口或器械时停在这一步，剩下的按键在事件处理完之后继续
+                if (event_type != EventType::NONE)
+                {
+                    ++i;
+                    break;
+                }
             }
-            log(LogLevel::DEBUG, "------------------");
+            input->unreadKeys(std::vector<int>(keys.begin() + i, keys.end()));
+            GAME_LOG(DEBUG, "------------------");
             pos = map->getPos();
             view->drawPoMove(last_pos, pos);
-            log(LogLevel::DEBUG, "Move Success!");
-            handleEvent(event_type);
+            GAME_LOG(DEBUG, "Move Success!");
+            if (event_type != EventType::NONE)
+                handleEvent(event_type);
         }
         return Message("Move Success!", 0);
     }
     case EventType::AC_NPC:
     {
         // 从move 拿到NPCid -> 借助Scene获取名称 -> 创建NPC对象 -> 顺序调用即可
-        log(LogLevel::DEBUG, "AC_NPC");
+        GAME_LOG(DEBUG, "AC_NPC");
         view = View::getInstance();
         if (NPCid == -1)
             return Message("Invalid NPC id!", -1);
         std::string NPCname = scene->getNPCname(NPCid);
-        log(LogLevel::DEBUG, "Got name!" + NPCname);
+        GAME_LOG(DEBUG, "Got name!" + NPCname);
         if (NPCname.empty())
             return Message("Invalid NPC id!", -1);
         npc = nullptr;
@@ -324,12 +388,12 @@ Message Controller::handleEvent(EventType &event_type)
     }
     case EventType::AC_INST:
     {
-        log(LogLevel::DEBUG, "AC_NPC");
+        GAME_LOG(DEBUG, "AC_NPC");
         view = View::getInstance();
         if (NPCid == -1)
             return Message("Invalid NPC id!", -1);
         std::string NPCname = scene->getNPCname(NPCid);
-        log(LogLevel::DEBUG, "Got name!" + NPCname);
+        GAME_LOG(DEBUG, "Got name!" + NPCname);
         if (NPCname.empty())
             return Message("Invalid NPC id!", -1);
         npc = nullptr;
@@ -362,7 +426,8 @@ Message Controller::handleEvent(EventType &event_type)
     }
     case EventType::REFRESH:
     {
-        view->reDraw();
+        // 终端内容可能已被破坏，清屏后输出所有格子
+        view->reDraw(true);
         return Message("Refresh Success!", 0);
     }
     case EventType::STATUS:
@@ -379,20 +444,24 @@ Message Controller::handleEvent(EventType &event_type)
     }
     case EventType::JUMP:
     {
-        log(LogLevel::DEBUG,"JUMP"+std::to_string(NPCid));
-        // 拿到map.move的NPCid->给Scene对象->拿到场景文件名->重新创建Scene(新场景)->创建Map(新地图)->初始化地图数据->重新绘制地图->提示用户场景名称
+        GAME_LOG(DEBUG, "JUMP"+std::to_string(NPCid));
+        // 拿到map.move的NPCid->给Scene对象->拿到场景文件名->从缓存取出Scene和Map(新场景)->主角回到出生点->重新绘制地图->提示用户场景名称
         if (NPCid == -1)
         {
             return Message("Jump to default map.", 0);
         }
         std::string scene_name = scene->getSceneName(NPCid+1);
-        log(LogLevel::DEBUG,"scene"+scene_name);
+        GAME_LOG(DEBUG, "scene"+scene_name);
         if (scene_name.empty())
         {
             return Message("Invalid NPC id!", -1);
         }
-        scene = std::make_shared<Scene>(scene_name);
-        map = std::make_shared<Map>(scene_name+".txt", Position(-1, -1));
+        FlightRecorder::getInstance().record(FlightRecorder::Kind::JUMP, static_cast<int>(event_type),
+                                             map->getPos(), NPCid, 0, scene_name);
+        scene = world->getScene(scene_name);
+        map = world->getMap(scene_name + ".txt");
+        // 玩家在新场景中走动时，后台加载下一步可能进入的场景
+        world->prefetchNeighbours(scene_name);
         view = View::getInstance();
         view->clearOutputs();
         view->reDraw();
@@ -424,7 +493,7 @@ Message Controller::handleEvent(EventType &event_type)
                 ch = ch - '0';
                 break;
             }
-            else if (ch == 27)
+            else if (ch == 27 || ch == -1)
             {
                 ch = -1;
                 break;
@@ -434,7 +503,7 @@ Message Controller::handleEvent(EventType &event_type)
                 view->printQuestion("", "Invalid input. Please enter a number.", "", Rgb(255, 255, 0));
             }
         }
-        log(LogLevel::DEBUG, "Got index: " + std::to_string(ch));
+        GAME_LOG(DEBUG, "Got index: " + std::to_string(ch));
         if (ch != -1)
         {
             backpack->useFunctionOfItem(ch, *protagonist);
@@ -469,7 +538,7 @@ Message Controller::handleEvent(EventType &event_type)
                 else if (option[0] == '0' && option.length() >= 2)
                 {
                     Message msg_store = store->showProducts(std::stoi(option.substr(1)) - 1);
-                    log(LogLevel::DEBUG, "page_index = " + (std::stoi(option.substr(1)) - 1));
+                    GAME_LOG(DEBUG, "page_index = " + std::to_string(std::stoi(option.substr(1)) - 1));
                     if (msg_store.msg == "Page error.")
                     {
                         view->printQuestion("", "Page error. Please enter a valid page number.", "", Rgb(255, 255, 0));
@@ -503,7 +572,7 @@ Message Controller::handleEvent(EventType &event_type)
                 }
                 continue;
             }
-            else if (ch == 27)
+            else if (ch == 27 || ch == -1)
             {
                 index = -1;
                 view->printCmd("");
@@ -540,6 +609,77 @@ Message Controller::handleEvent(EventType &event_type)
             help_msgs.push_back(line);
         }
         view->printOptions(help_msgs);
+        return Message("Help Success!", 0);
+    }
+    case EventType::DUMP:
+    {
+        view = View::getInstance();
+        std::filesystem::path file_path;
+        Message msg = FlightRecorder::getInstance().dump(log_dir, file_path);
+        view->printQuestion("", msg.msg, "", msg.status ? Rgb(255, 0, 0) : Rgb(255, 255, 0));
+        return msg;
+    }
+    case EventType::GOTO:
+    {
+        view = View::getInstance();
+        // 地图中的 NPC 大多和器械一样用字母表示，由场景的 NPC 表区分，编号按从上到下、从左到右的顺序
+        int target_type = goto_type, target_id = goto_id;
+        if (goto_type == 0)
+        {
+            target_type = target_id = -1;
+            int seen = 0;
+            for (const auto &entity : map->getEntities())
+            {
+                if (entity.type != Map::EntityType::NPC && entity.type != Map::EntityType::INSTRUMENT)
+                    continue;
+                if (!scene->isNPC(entity.code) || seen++ != goto_id)
+                    continue;
+                target_type = entity.type == Map::EntityType::NPC ? 0 : 1;
+                target_id = entity.id;
+                break;
+            }
+        }
+        std::vector<int> directions;
+        Message route = goto_type == -1   ? Message("用法：goto <exit|npc> <id>", -1)
+                        : target_type == -1 ? Message("目标不存在", -1)
+                                            : map->goTo(target_id, target_type, directions);
+        if (route.status)
+        {
+            view->printQuestion("", route.msg, "", Rgb(255, 0, 0));
+            return route;
+        }
+        view->printQuestion("", "按下ESC键停止自动寻路。", "", Rgb(255, 255, 0));
+        // 路线较长时一帧走多步，整段路最多绘制 GOTO_MAX_FRAMES 帧
+        const size_t per_frame = (directions.size() + GOTO_MAX_FRAMES - 1) / GOTO_MAX_FRAMES;
+        std::vector<int> pending_keys;
+        event_type = EventType::NONE;
+        bool stopped = false;
+        for (size_t i = 0; i < directions.size() && event_type == EventType::NONE && !stopped;)
+        {
+            Position last_pos = map->getPos();
+            for (size_t end = std::min(directions.size(), i + per_frame); i < end; ++i)
+            {
+                map->moveProtagonist(directions[i], event_type, NPCid);
+                FlightRecorder::getInstance().record(FlightRecorder::Kind::MOVE, static_cast<int>(event_type),
+                                                     map->getPos(), NPCid, directions[i]);
+                if (event_type != EventType::NONE)
+                    break;
+            }
+            view->drawPoMove(last_pos, map->getPos());
+            view->present();
+            if (event_type != EventType::NONE || i == directions.size())
+                break;
+            // 两帧之间留出间隔，期间按下 ESC 停止，其余按键在寻路结束后处理
+            int ch = input->waitKeyDown(GOTO_FRAME_MS);
+            if (ch == InputSource::KEY_ESC || ch == -1)
+                stopped = true;
+            else if (ch != InputSource::KEY_TIMEOUT)
+                pending_keys.push_back(ch);
+        }
+        input->unreadKeys(pending_keys);
+        if (event_type != EventType::NONE)
+            handleEvent(event_type);
+        return Message(stopped ? "Goto stopped." : "Goto Success!", 0);
     }
     case EventType::NONE:
     {
@@ -602,7 +742,11 @@ Message Controller::playerLogin(std::string &user_name)
     do
     {
         std::cout << "Enter username: ";
-        std::getline(std::cin, name);
+        if (!input->readLine(name))
+        {
+            std::cout << std::endl;
+            return Message("输入已关闭", -1);
+        }
 
         if (name.empty())
         {
@@ -639,12 +783,19 @@ Message Controller::playerLogin(std::string &user_name)
 int Controller::run()
 {
     init();
+    FlightRecorder::getInstance().installCrashHandlers(log_dir);
     std::cout << "初始化成功" << std::endl;
     std::string user_name;
-    playerLogin(user_name);
+    Message login_msg = playerLogin(user_name);
+    if (login_msg.status != 0)
+    {
+        log(LogLevel::ERR, login_msg.msg);
+        flushLogs();
+        return 1;
+    }
     load(user_name);
-    log(LogLevel::DEBUG, "运行游戏...");
-    log(LogLevel::DEBUG, "DEBUG...");
+    GAME_LOG(DEBUG, "运行游戏...");
+    GAME_LOG(DEBUG, "DEBUG...");
     bool running = true;
     // 防止死循环
     // TODO 修改回合次数
@@ -666,6 +817,8 @@ int Controller::run()
 
     // 保存游戏
     save();
+    flushLogs();
+    view->present();
 
     // 保持界面完整性
     std::cout << "\n\n";
@@ -679,6 +832,11 @@ std::filesystem::path Controller::getRootDir() const {
 void Controller::gameExit() {
     cout << std::endl << std::endl;
     save();
+    flushLogs();
+    if (view)
+        view->present();
+    std::filesystem::path file_path;
+    std::cerr << FlightRecorder::getInstance().dump(log_dir, file_path).msg << std::endl;
     View::enableCursor();
     exit(1);
 }
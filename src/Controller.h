@@ -3,8 +3,10 @@
  */
 #pragma once
 #include <iostream>
+#include <atomic>
 #include <filesystem>
 #include <memory>
+#include <thread>
 #include "tools.h"
 #include <set>
 #include <ctime>
@@ -16,15 +18,25 @@
 #include <cereal/types/memory.hpp>
 #include <cereal/types/vector.hpp>
 
+/**
+ * @brief 编译期日志等级，低于该等级的 GAME_LOG 调用会被完全移除
+ * @details 由 CMake 的 OUCSurvSim_LOG_LEVEL 选项设置，0-3 依次对应 DEBUG, INFO, WARN, ERR
+ */
+#ifndef OUCSurvSim_LOG_MIN_LEVEL
+#define OUCSurvSim_LOG_MIN_LEVEL 0
+#endif
+
 class View;
 class Scene;
 class Backpack;
-class InputHandler;
+class InputSource;
 class NPC;
 class Protagonist;
 class Map;
 class Store;
 class FinalExam;
+class LogSink;
+class World;
 /**
  * @brief MVC 模式中的 Controller
  * @details 程序的总控制器\n
@@ -65,11 +77,35 @@ public:
 
     /**
      * @brief 日志函数
+     * @details 控制台输出是同步的，写文件交给 LogSink 的后台线程完成
      * @param level 日志等级
      * @param msg 日志消息
      */
     void log(const LogLevel &level, const std::string &msg);
 
+    /**
+     * @brief 等待所有日志写入文件
+     */
+    void flushLogs();
+
+    /**
+     * @brief 该等级的日志是否被编译进程序
+     * @note 供 GAME_LOG 在编译期裁剪调用，详见 Log.h
+     */
+    static constexpr bool compiledIn(const LogLevel &level) {
+        return static_cast<int>(level) >= OUCSurvSim_LOG_MIN_LEVEL;
+    }
+
+    /**
+     * @brief 该等级的日志在运行时是否需要处理
+     * @details 只有运行时日志等级为 DEBUG 时才处理 DEBUG 消息，被过滤的 DEBUG 消息
+     *          不会写入任何日志文件，包括 Debug.log；其余等级的消息总会被写入 Debug.log\n
+     *          该函数只读取一个原子变量，不会构造 Controller 实例
+     */
+    static bool enabled(const LogLevel &level) {
+        return level >= log_threshold.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief 游戏入口函数
      * @details 游戏入口函数，供 main() 调用\n
@@ -97,11 +133,14 @@ public:
     std::shared_ptr<Protagonist>  protagonist = nullptr;
     std::shared_ptr<NPC>          npc         = nullptr;
     std::shared_ptr<View>         view        = nullptr;
-    std::shared_ptr<InputHandler> input       = nullptr;
+    // 输入源，默认为终端（InputHandler），可以在 run() 之前替换为其他输入源
+    std::shared_ptr<InputSource>  input       = nullptr;
     std::shared_ptr<Backpack>     backpack    = nullptr;
     std::shared_ptr<Scene>        scene       = nullptr;
     std::shared_ptr<Store>        store       = nullptr;
     std::shared_ptr<FinalExam>    final_exam  = nullptr;
+    // 场景与地图缓存，scene 和 map 都从这里取得
+    std::shared_ptr<World>        world       = nullptr;
     template <class Archive>
     void serialize(Archive &archive)
     {
@@ -115,18 +154,24 @@ private:
     // 项目根目录
     std::filesystem::path root_dir;
 
-    // 该文件永远需要被写入，且会写入所有消息，囊括了 info, warn and error
-    inline static const std::string DEBUG_FILE = "Debug.log";
-    // 只有设置为需要写入才写入
-    inline static const std::string INFO_FILE = "Info.log";
-    // 只有设置为需要写入才写入
-    inline static const std::string WARN_FILE = "Warnings.log";
-    // 永远写入
-    inline static const std::string ERROR_FILE = "Error.log";
     // 日志目录
     std::filesystem::path log_dir;
     // 日志等级
     LogLevel level;
+    // GAME_LOG 的运行时阈值，由日志等级决定
+    inline static std::atomic<LogLevel> log_threshold{LogLevel::INFO};
+    // 日志文件：Debug.log 写入所有通过运行时阈值的消息（DEBUG 消息只有日志等级
+    // 为 DEBUG 时才写入），Info.log/Warnings.log 只有设置为对应等级才写入，
+    // Error.log 永远写入
+    std::unique_ptr<LogSink> log_sink;
+    // 构造 Controller 的线程，只有它可以访问 View 和 Model
+    std::thread::id main_thread = std::this_thread::get_id();
+    // goto 命令的目标：0 为 NPC，2 为出口，格式错误时为 -1
+    int goto_type = -1;
+    int goto_id = -1;
+    // 自动寻路每一帧的间隔(ms)和最多绘制的帧数，路线较长时一帧走多步
+    constexpr static int GOTO_FRAME_MS = 40;
+    constexpr static size_t GOTO_MAX_FRAMES = 25;
 
     // 构造函数
     Controller(const LogLevel &level, const std::filesystem::path &log_dir, const std::filesystem::path &root_dir);
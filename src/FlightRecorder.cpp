@@ -0,0 +1,214 @@
+/**
+ * @file FlightRecorder.cpp
+ */
+#include "FlightRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <vector>
+#include <fcntl.h>
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#endif
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#   define FR_OPEN(path) ::_open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644)
+#   define FR_WRITE ::_write
+#   define FR_CLOSE ::_close
+#else
+#   include <unistd.h>
+#   define FR_OPEN(path) ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+#   define FR_WRITE ::write
+#   define FR_CLOSE ::close
+#endif
+
+namespace {
+    const char MAGIC[8] = {'O', 'U', 'C', 'F', 'L', 'T', 'R', '\0'};
+
+    int64_t steadyNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 读 steady_clock 要几十纳秒，x86 上直接读 TSC
+    uint64_t readTicks() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(steadyNs());
+#endif
+    }
+
+    bool writeAll(int fd, const char *data, size_t size) {
+        while (size > 0) {
+            auto n = FR_WRITE(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 20)));
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    const char *kindName(uint8_t kind) {
+        switch (static_cast<FlightRecorder::Kind>(kind)) {
+            case FlightRecorder::Kind::LOG:   return "LOG  ";
+            case FlightRecorder::Kind::EVENT: return "EVENT";
+            case FlightRecorder::Kind::MOVE:  return "MOVE ";
+            case FlightRecorder::Kind::JUMP:  return "JUMP ";
+            case FlightRecorder::Kind::MARK:  return "MARK ";
+        }
+        return "?    ";
+    }
+
+    const char *levelName(uint8_t level) {
+        static const char *names[] = {"DEBUG", "INFO", "WARN", "ERR"};
+        return level < 4 ? names[level] : "?";
+    }
+
+    const int FATAL_SIGNALS[] = {
+        SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#if !defined(_WIN32) && !defined(_WIN64)
+        SIGBUS,
+#endif
+    };
+}
+
+FlightRecorder &FlightRecorder::getInstance() {
+    static FlightRecorder instance;
+    return instance;
+}
+
+FlightRecorder::FlightRecorder():
+    records(),
+    start_ticks(readTicks()),
+    start_steady_ns(steadyNs()),
+    start_unix_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()) {
+    // 构造函数
+}
+
+void FlightRecorder::record(const Kind &kind, const int &code, const Position &pos,
+                            const int &npc_id, const int &arg, std::string_view text) {
+    uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Record &r = records[index & (CAPACITY - 1)];
+    r.ticks = readTicks() - start_ticks;
+    r.kind = static_cast<uint8_t>(kind);
+    r.code = static_cast<uint8_t>(code);
+    r.length = static_cast<uint8_t>(std::min(text.size(), sizeof(r.text)));
+    r.x = static_cast<int16_t>(pos.x);
+    r.y = static_cast<int16_t>(pos.y);
+    r.npc_id = npc_id;
+    r.arg = arg;
+    std::memcpy(r.text, text.data(), r.length);
+}
+
+bool FlightRecorder::dumpToPath(const char *path) {
+    int fd = FR_OPEN(path);
+    if (fd < 0) return false;
+    uint64_t total_count = head.load(std::memory_order_acquire);
+    uint64_t count = std::min<uint64_t>(total_count, CAPACITY);
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.record_size = sizeof(Record);
+    header.count = count;
+    header.total = total_count;
+    header.start_unix_ns = start_unix_ns;
+    int64_t elapsed_ns = steadyNs() - start_steady_ns;
+    header.ticks_per_ns = elapsed_ns > 0 ? static_cast<double>(readTicks() - start_ticks) / elapsed_ns : 1.0;
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header));
+    // 从最旧的记录开始写，最多分成两段
+    size_t first = static_cast<size_t>((total_count - count) & (CAPACITY - 1));
+    size_t first_len = std::min<size_t>(static_cast<size_t>(count), CAPACITY - first);
+    ok = ok && writeAll(fd, reinterpret_cast<const char *>(&records[first]), first_len * sizeof(Record));
+    ok = ok && writeAll(fd, reinterpret_cast<const char *>(&records[0]),
+                        (static_cast<size_t>(count) - first_len) * sizeof(Record));
+    FR_CLOSE(fd);
+    return ok;
+}
+
+Message FlightRecorder::dump(const std::filesystem::path &dir, std::filesystem::path &file_path) {
+    time_t now = time(NULL);
+    struct tm *local_tm = localtime(&now);
+    char name[64];
+    strftime(name, sizeof(name), "flight-%Y%m%d-%H%M%S.bin", local_tm);
+    file_path = dir / name;
+    record(Kind::MARK, 0, {-1, -1}, -1, 0, "dump");
+    if (!dumpToPath(file_path.string().c_str())) {
+        return {"无法写入飞行记录: " + file_path.string(), -1};
+    }
+    return {"飞行记录已导出: " + file_path.string(), 0};
+}
+
+void FlightRecorder::installCrashHandlers(const std::filesystem::path &dir) {
+    std::string path = (dir / CRASH_FILE).string();
+    if (path.size() >= sizeof(crash_path)) return;
+    std::memcpy(crash_path, path.c_str(), path.size() + 1);
+    for (int sig : FATAL_SIGNALS) {
+        std::signal(sig, &FlightRecorder::onFatalSignal);
+    }
+}
+
+void FlightRecorder::onFatalSignal(int sig) {
+    auto &recorder = getInstance();
+    if (recorder.crash_path[0]) {
+        recorder.dumpToPath(recorder.crash_path);
+    }
+    // 交给默认的处理函数，保留原本的退出状态和 core dump
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+Message FlightRecorder::decode(std::istream &in, std::ostream &out) {
+    FileHeader header{};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return {"不是飞行记录文件", -1};
+    }
+    if (header.version != VERSION || header.record_size != sizeof(Record)) {
+        return {"不支持的飞行记录版本: " + std::to_string(header.version), -1};
+    }
+    if (!(header.ticks_per_ns > 0)) {
+        header.ticks_per_ns = 1.0;
+    }
+
+    time_t start = static_cast<time_t>(header.start_unix_ns / 1000000000LL);
+    char start_str[64];
+    strftime(start_str, sizeof(start_str), "%Y-%m-%d %H:%M:%S", localtime(&start));
+    out << "# flight recorder, started " << start_str << ", "
+        << header.count << " of " << header.total << " records" << std::endl;
+
+    Record r;
+    uint64_t decoded = 0;
+    while (decoded < header.count && in.read(reinterpret_cast<char *>(&r), sizeof(r))) {
+        ++decoded;
+        out << "+" << std::fixed << std::setprecision(6) << r.ticks / header.ticks_per_ns / 1e9 << "s "
+            << kindName(r.kind) << " ";
+        switch (static_cast<Kind>(r.kind)) {
+            case Kind::LOG:
+                out << std::left << std::setw(5) << levelName(r.code) << std::right;
+                break;
+            case Kind::EVENT:
+            case Kind::MOVE:
+            case Kind::JUMP:
+                out << getStr(static_cast<EventType>(r.code));
+                break;
+            default:
+                break;
+        }
+        if (r.x >= 0 || r.y >= 0) out << " pos=(" << r.x << "," << r.y << ")";
+        if (r.npc_id != -1) out << " id=" << r.npc_id;
+        if (r.arg) out << " arg=" << r.arg;
+        if (r.length) out << " \"" << std::string(r.text, std::min<size_t>(r.length, sizeof(r.text))) << "\"";
+        out << std::endl;
+    }
+    if (decoded != header.count) {
+        return {"飞行记录文件不完整", 1};
+    }
+    return {"Success", 0};
+}
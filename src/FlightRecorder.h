@@ -0,0 +1,151 @@
+/**
+ * @file FlightRecorder.h
+ * @details 飞行记录仪：在内存中保存最近的日志和事件，出现问题时导出到日志目录
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "tools.h"
+
+/**
+ * @brief 飞行记录仪
+ * @details 一个预先分配好的定长环形缓冲区，每条记录固定 64 字节，记录时只做一次原子
+ *          自增、一次读时钟和几次赋值，不会分配内存\n
+ *          x86 上使用 TSC 作为时钟，导出时再用 steady_clock 标定成纳秒\n
+ *          导出时机：\n
+ *          1. Controller::gameExit\n
+ *          2. 收到致命信号（SIGSEGV, SIGABRT 等），导出到 flight-crash.bin\n
+ *          3. 玩家输入 dump 命令\n
+ *          导出的二进制文件可以通过 `game decode-flight <file>` 解码
+ * @note 缓冲区满后覆盖最旧的记录
+ */
+class FlightRecorder {
+public:
+    /**
+     * @brief 记录类型
+     */
+    enum class Kind : uint8_t {
+        LOG = 1,   ///< 一条日志，code 为日志等级
+        EVENT = 2, ///< Controller 开始处理一个事件，code 为 EventType
+        MOVE = 3,  ///< 主角移动了一步，code 为移动后的 EventType, arg 为方向
+        JUMP = 4,  ///< 场景跳转，text 为场景名
+        MARK = 5   ///< 其他标记，例如 dump
+    };
+
+    /**
+     * @brief 一条记录，正好占一个缓存行
+     */
+    struct Record {
+        uint64_t ticks;        ///< 距离记录仪启动的时钟刻度，见 FileHeader::ticks_per_ns
+        uint8_t kind;          ///< Kind
+        uint8_t code;          ///< 日志等级或 EventType, 取决于 kind
+        uint8_t length;        ///< text 的有效长度
+        uint8_t reserved;      ///< 保留
+        int16_t x;             ///< 主角坐标
+        int16_t y;             ///< 主角坐标
+        int32_t npc_id;        ///< NPC/出口 id
+        int32_t arg;           ///< 附加参数
+        char text[40];         ///< 截断的消息
+    };
+    static_assert(sizeof(Record) == 64, "Record 应当占 64 字节");
+
+    /**
+     * @brief 导出文件头
+     */
+    struct FileHeader {
+        char magic[8];            ///< "OUCFLTR"
+        uint32_t version;         ///< 文件格式版本
+        uint32_t record_size;     ///< sizeof(Record)
+        uint64_t count;           ///< 文件中的记录数
+        uint64_t total;           ///< 启动以来的记录总数
+        int64_t start_unix_ns;    ///< 记录仪启动时的 Unix 时间
+        double ticks_per_ns;      ///< 导出时标定的每纳秒时钟刻度
+    };
+
+    /**
+     * @brief 环形缓冲区的容量（记录数），必须是 2 的幂
+     */
+    static constexpr size_t CAPACITY = 4096;
+
+    /**
+     * @brief 文件格式版本
+     */
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief 崩溃时导出的文件名
+     */
+    inline static const std::string CRASH_FILE = "flight-crash.bin";
+
+    /**
+     * @brief 获取全局唯一的记录仪
+     */
+    static FlightRecorder &getInstance();
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    /**
+     * @brief 写入一条记录
+     * @param kind 记录类型
+     * @param code 日志等级或 EventType, 见 Kind
+     * @param pos 主角坐标，未知时传 {-1, -1}
+     * @param npc_id NPC/出口 id
+     * @param arg 附加参数，例如移动方向
+     * @param text 消息，超过 40 字节的部分会被截断
+     */
+    void record(const Kind &kind,
+                const int &code,
+                const Position &pos = {-1, -1},
+                const int &npc_id = -1,
+                const int &arg = 0,
+                std::string_view text = {});
+
+    /**
+     * @brief 导出到 dir 目录下的一个新文件，文件名带有时间
+     * @param dir 导出目录
+     * @param[out] file_path 导出的文件路径
+     * @return Message
+     */
+    Message dump(const std::filesystem::path &dir, std::filesystem::path &file_path);
+
+    /**
+     * @brief 安装致命信号的处理函数
+     * @details 收到信号时把缓冲区导出到 dir/flight-crash.bin，然后交给默认的处理函数
+     * @param dir 导出目录
+     */
+    void installCrashHandlers(const std::filesystem::path &dir);
+
+    /**
+     * @brief 启动以来的记录总数
+     */
+    uint64_t total() const { return head.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 解码一个导出的文件
+     * @param in 二进制输入
+     * @param out 文本输出
+     * @return Message
+     */
+    static Message decode(std::istream &in, std::ostream &out);
+
+private:
+    FlightRecorder();
+
+    alignas(64) Record records[CAPACITY];
+    std::atomic<uint64_t> head{0};
+    uint64_t start_ticks;
+    int64_t start_steady_ns;
+    int64_t start_unix_ns;
+    // 信号处理函数中不能分配内存，提前准备好崩溃文件的路径
+    char crash_path[1024] = {};
+
+    // 只使用 open/write/close 导出，可以在信号处理函数中调用
+    bool dumpToPath(const char *path);
+
+    static void onFatalSignal(int sig);
+};
@@ -1,4 +1,10 @@
 #include "InputHandler.h"
+#include <chrono>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <cerrno>
+#include <cstdlib>
+#include <poll.h>
+#endif
 
 #if defined(_WIN32) || defined(_WIN64)
 // Windows 实现
@@ -112,7 +118,7 @@ InputHandler::~InputHandler()
     // Windows 不需要特殊清理
 }
 
-int InputHandler::waitKeyDown()
+int InputHandler::readKey(const int &timeout_ms)
 {
     capturedKey = -1;
     keyCaptured = false;
@@ -126,11 +132,23 @@ int InputHandler::waitKeyDown()
         return -1;
     }
 
-    // 消息循环
+    // 消息循环，没有消息时阻塞在 MsgWaitForMultipleObjects 上，而不是用 PeekMessage 空转
     MSG msg;
+    ULONGLONG start = GetTickCount64();
     while (!keyCaptured)
     {
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        DWORD wait = INFINITE;
+        if (timeout_ms >= 0)
+        {
+            ULONGLONG elapsed = GetTickCount64() - start;
+            if (elapsed >= static_cast<ULONGLONG>(timeout_ms))
+                break;
+            wait = static_cast<DWORD>(timeout_ms - elapsed);
+        }
+        // 键盘钩子的回调通过发送给本线程的消息触发，QS_ALLINPUT 包含了这类消息
+        if (MsgWaitForMultipleObjects(0, NULL, FALSE, wait, QS_ALLINPUT) == WAIT_TIMEOUT)
+            break;
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
@@ -144,16 +162,29 @@ int InputHandler::waitKeyDown()
         hKeyboardHook = nullptr;
     }
 
-    return capturedKey;
+    return keyCaptured ? capturedKey.load() : KEY_TIMEOUT;
 }
 
 #else
 
-// Linux 实现 (使用 termios)
-InputHandler::InputHandler() : raw_mode_enabled(false)
+// Linux 实现 (使用 termios + poll)
+
+namespace {
+    // Controller 与 View 互相持有，InputHandler 不一定会被析构，进程退出时再恢复一次终端设置
+    struct termios exit_termios;
+    int exit_fd = -1;
+
+    void restoreTerminalAtExit()
+    {
+        if (exit_fd >= 0)
+            tcsetattr(exit_fd, TCSANOW, &exit_termios);
+    }
+}
+
+InputHandler::InputHandler(const int &fd) : fd(fd), raw_mode_enabled(false)
 {
-    // 保存原始终端设置
-    tcgetattr(STDIN_FILENO, &orig_termios);
+    // 保存原始终端设置，输入不是终端（管道、文件）时不修改终端设置
+    is_tty = isatty(fd) && tcgetattr(fd, &orig_termios) == 0;
 }
 
 InputHandler::~InputHandler()
@@ -167,7 +198,7 @@ InputHandler::~InputHandler()
 
 void InputHandler::enableRawMode()
 {
-    if (raw_mode_enabled)
+    if (raw_mode_enabled || !is_tty)
         return;
 
     struct termios raw = orig_termios;
@@ -175,13 +206,18 @@ void InputHandler::enableRawMode()
     // 修改终端设置
     raw.c_lflag &= ~(ICANON | ECHO | ISIG); // 禁用规范模式、回显和信号处理
     raw.c_iflag &= ~(IXON | ICRNL);         // 禁用软件流控制和CR到NL的转换
-    raw.c_oflag &= ~(OPOST);                // 禁用输出处理
-    raw.c_cc[VMIN] = 0;                     // 最小字符数为0（非阻塞）
-    raw.c_cc[VTIME] = 1;                    // 超时时间为0.1秒
+    // raw 模式会一直保持，保留输出处理，否则两次按键之间输出的 "\n" 不会回到行首
+    raw.c_cc[VMIN] = 1;                     // 阻塞读取，等待由 poll 完成
+    raw.c_cc[VTIME] = 0;
 
     // 应用新设置
-    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    tcsetattr(fd, TCSANOW, &raw);
     raw_mode_enabled = true;
+
+    static const bool registered = (std::atexit(&restoreTerminalAtExit) == 0);
+    (void)registered;
+    exit_termios = orig_termios;
+    exit_fd = fd;
 }
 
 void InputHandler::disableRawMode()
@@ -190,18 +226,62 @@ void InputHandler::disableRawMode()
         return;
 
     // 恢复原始终端设置
-    tcsetattr(STDIN_FILENO, TCSANOW, &orig_termios);
+    tcsetattr(fd, TCSANOW, &orig_termios);
     raw_mode_enabled = false;
+    if (exit_fd == fd)
+        exit_fd = -1;
+}
+
+int InputHandler::readByte(const int &timeout_ms)
+{
+    if (read_pos < read_len)
+        return read_buffer[read_pos++];
+
+    using namespace std::chrono;
+    auto deadline = steady_clock::now() + milliseconds(timeout_ms);
+    while (true)
+    {
+        int wait_ms = -1;
+        if (timeout_ms >= 0)
+        {
+            auto left = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+            wait_ms = left > 0 ? static_cast<int>(left) : 0;
+        }
+
+        // 阻塞在 poll 上直到有输入或超时
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (ready == 0)
+            return KEY_TIMEOUT;
+
+        ssize_t n = read(fd, read_buffer, sizeof(read_buffer));
+        if (n > 0)
+        {
+            read_pos = 1;
+            read_len = static_cast<size_t>(n);
+            return read_buffer[0];
+        }
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        // 输入已关闭（EOF）或读取出错
+        return -1;
+    }
 }
 
 int InputHandler::readEscapeSequence()
 {
-    char seq[2];
+    int seq[2];
 
-    // 读取转义序列的后续字符
-    if (read(STDIN_FILENO, &seq[0], 1) != 1)
+    // 读取转义序列的后续字符，单独按下 ESC 时 100ms 内不会有后续字符
+    if ((seq[0] = readByte(100)) < 0)
         return KEY_ESC;
-    if (read(STDIN_FILENO, &seq[1], 1) != 1)
+    if ((seq[1] = readByte(100)) < 0)
         return KEY_ESC;
 
     // 解析转义序列
@@ -223,68 +303,55 @@ int InputHandler::readEscapeSequence()
     return KEY_ESC; // 未知转义序列
 }
 
-int InputHandler::waitKeyDown()
+int InputHandler::readKey(const int &timeout_ms)
 {
     enableRawMode();
 
-    int c = -1;
-    fd_set fds;
-    struct timeval tv;
+    using namespace std::chrono;
+    auto deadline = steady_clock::now() + milliseconds(timeout_ms);
 
     // 等待按键
     while (true)
     {
-        FD_ZERO(&fds);
-        FD_SET(STDIN_FILENO, &fds);
+        int wait_ms = -1;
+        if (timeout_ms >= 0)
+        {
+            auto left = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+            wait_ms = left > 0 ? static_cast<int>(left) : 0;
+        }
 
-        // 设置超时时间为100毫秒
-        tv.tv_sec = 0;
-        tv.tv_usec = 0;
+        int ch = readByte(wait_ms);
+        if (ch < 0)
+            return ch;
 
-        // 检查是否有输入
-        if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0)
+        // 处理转义序列（功能键）
+        if (ch == '\033')
+        { // ESC字符
+            return readEscapeSequence();
+        }
+        // 处理Backspace键
+        else if (ch == 127 || ch == 8)
+        {
+            return KEY_BACKSPACE;
+        }
+        // 处理Enter键
+        else if (ch == '\r' || ch == '\n')
+        {
+            return KEY_ENTER;
+        }
+        // 处理普通字符
+        else if (ch >= 32 && ch <= 126)
         {
-            // 读取一个字符
-            char ch;
-            if (read(STDIN_FILENO, &ch, 1) == 1)
+            // 转换为小写字母
+            if (ch >= 'A' && ch <= 'Z')
             {
-                // 处理转义序列（功能键）
-                if (ch == '\033')
-                { // ESC字符
-                    c = readEscapeSequence();
-                    break;
-                }
-                // 处理Backspace键
-                else if (ch == 127 || ch == 8)
-                {
-                    c = KEY_BACKSPACE;
-                    break;
-                }
-                // 处理Enter键
-                else if (ch == '\r' || ch == '\n')
-                {
-                    c = KEY_ENTER;
-                    break;
-                }
-                // 处理普通字符
-                else if (ch >= 32 && ch <= 126)
-                {
-                    // 转换为小写字母
-                    if (ch >= 'A' && ch <= 'Z')
-                    {
-                        ch += 32;
-                    }
-                    c = ch;
-                    break;
-                }
+                ch += 32;
             }
+            return ch;
         }
 
-        // 可以在这里添加其他处理，如检查退出条件等
+        // 其他字符忽略，继续等待
     }
-
-    disableRawMode();
-    return c;
 }
 
 #endif
@@ -4,6 +4,7 @@
 #include <atomic>
 #include <map>
 #include <iostream>
+#include "InputSource.h"
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <Windows.h>
@@ -14,11 +15,12 @@
 #endif
 
 /**
- * @brief 等待并获取键盘输入
+ * @brief 等待并获取键盘输入，终端上的 InputSource
  * @author Yang
  *
  * 调用 waitKeyDown 函数可获取键盘输入，支持数字、字母、空格、Esc、Enter、方向、退格键、_ 等按键。
- * 函数会阻塞直到有符合条件的按键被按下。
+ * 函数会阻塞直到有符合条件的按键被按下，等待期间不占用 CPU。
+ * 也可以传入超时时间，超时后返回 KEY_TIMEOUT，便于游戏循环定时执行其他逻辑。
  *
  * @return int 返回数字的原始值/字母和ESC的ASCII码值
  * @retval '0'-'9' 数字键0-9
@@ -28,27 +30,27 @@
  * @retval 95 '_'
  * @retval 'a'-'z' 字母键a-z(小写)
  * @retval "wsad" 对应 "上下左右"
- * @retval -1 获取按键失败
+ * @retval -1 获取按键失败（包括输入已关闭）
+ * @retval KEY_TIMEOUT 等待超时
  *
  * @note 此函数跨平台支持Windows和Linux系统
- * @note Windows使用键盘钩子实现，Linux使用termios实现
+ * @note Windows使用键盘钩子 + MsgWaitForMultipleObjects 实现，Linux使用termios + poll实现
+ * @note Linux 下第一次等待按键时进入 raw 模式，之后一直保持，直到析构或进程退出
  */
-class InputHandler {
+class InputHandler : public InputSource {
 public:
+#if defined(_WIN32) || defined(_WIN64)
     InputHandler();
-    ~InputHandler();
-    
-    int waitKeyDown();
-    
-    // 特殊键常量
-    static const int KEY_ENTER = 10;
-    static const int KEY_ESC = 27;
-    static const int KEY_BACKSPACE = 8;
-    static const int KEY_UNDERSCORE = 95;
-    static const int KEY_UP = 'w';
-    static const int KEY_DOWN = 's';
-    static const int KEY_LEFT = 'a';
-    static const int KEY_RIGHT = 'd';
+#else
+    /**
+     * @param fd 读取按键的文件描述符，默认为标准输入；不是终端时不修改终端设置
+     */
+    explicit InputHandler(const int &fd = STDIN_FILENO);
+#endif
+    ~InputHandler() override;
+
+protected:
+    int readKey(const int &timeout_ms) override;
     
 private:
 #if defined(_WIN32) || defined(_WIN64)
@@ -59,11 +61,18 @@ private:
     static int vkToAscii(int vkCode);
     static LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
 #else
+    int fd;
+    bool is_tty;
     struct termios orig_termios;
     bool raw_mode_enabled;
+    // 一次 read 读入多个字节，积压的按键不需要逐个系统调用
+    unsigned char read_buffer[64];
+    size_t read_pos = 0;
+    size_t read_len = 0;
     
     void enableRawMode();
     void disableRawMode();
+    int readByte(const int &timeout_ms);
     int readEscapeSequence();
 #endif
 };
@@ -0,0 +1,40 @@
+/**
+ * @file InputSource.cpp
+ */
+#include "InputSource.h"
+#include <iostream>
+
+int InputSource::waitKeyDown() {
+    return waitKeyDown(-1);
+}
+
+int InputSource::waitKeyDown(const int &timeout_ms) {
+    if (!pending_keys.empty()) {
+        int key = pending_keys.front();
+        pending_keys.pop_front();
+        return key;
+    }
+    // drainKeys 不等待，不算一次空闲
+    if (timeout_ms != 0 && idle_hook)
+        idle_hook();
+    return readKey(timeout_ms);
+}
+
+std::vector<int> InputSource::drainKeys(const size_t &max_keys) {
+    std::vector<int> keys;
+    while (keys.size() < max_keys) {
+        int key = waitKeyDown(0);
+        if (key < 0)
+            break;
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+void InputSource::unreadKeys(const std::vector<int> &keys) {
+    pending_keys.insert(pending_keys.begin(), keys.begin(), keys.end());
+}
+
+bool InputSource::readLine(std::string &line) {
+    return static_cast<bool>(std::getline(std::cin, line));
+}
@@ -0,0 +1,88 @@
+/**
+ * @file InputSource.h
+ * @details 输入源接口，Controller 通过它获取按键和登录时的用户名
+ */
+#pragma once
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 输入源
+ * @details 真实终端由 InputHandler 实现，脚本回放由 ReplayInput 实现\n
+ *          子类只需实现 readKey；被放回的按键由基类统一管理
+ */
+class InputSource {
+public:
+    // 特殊键常量
+    static constexpr int KEY_ENTER = 10;
+    static constexpr int KEY_ESC = 27;
+    static constexpr int KEY_BACKSPACE = 8;
+    static constexpr int KEY_UNDERSCORE = 95;
+    static constexpr int KEY_UP = 'w';
+    static constexpr int KEY_DOWN = 's';
+    static constexpr int KEY_LEFT = 'a';
+    static constexpr int KEY_RIGHT = 'd';
+    static constexpr int KEY_TIMEOUT = -2;
+
+    virtual ~InputSource() = default;
+
+    /**
+     * @brief 阻塞等待一个按键
+     * @return 按键，含义见 InputHandler；输入已关闭时返回 -1
+     */
+    int waitKeyDown();
+
+    /**
+     * @brief 等待一个按键，最多等待 timeout_ms 毫秒
+     * @param timeout_ms 超时时间(ms)，小于 0 表示一直等待
+     * @return 同 waitKeyDown()，超时返回 KEY_TIMEOUT
+     */
+    int waitKeyDown(const int &timeout_ms);
+
+    /**
+     * @brief 取出所有已经到达、尚未读取的按键，不会阻塞
+     * @details 按住方向键或粘贴时，终端里会积压多个按键，可以一次取出后批量处理
+     * @param max_keys 最多取出的按键数
+     * @return 按到达顺序排列的按键，含义同 waitKeyDown()
+     */
+    std::vector<int> drainKeys(const size_t &max_keys = 64);
+
+    /**
+     * @brief 把按键放回输入队列的最前面
+     * @details 之后的 waitKeyDown 会先按顺序返回这些按键
+     * @param keys 按键
+     */
+    void unreadKeys(const std::vector<int> &keys);
+
+    /**
+     * @brief 读取一行文本，用于登录时输入用户名
+     * @details 默认从标准输入读取
+     * @param[out] line 读到的一行
+     * @return 输入已关闭时返回 false
+     */
+    virtual bool readLine(std::string &line);
+
+    /**
+     * @brief 设置等待输入之前调用的函数
+     * @details 每次需要等待新的按键（没有被放回的按键，且允许等待）之前调用，
+     *          Controller 用它在等待玩家操作之前输出积攒的画面
+     * @param hook 为空时不调用
+     */
+    void setIdleHook(std::function<void()> hook) { idle_hook = std::move(hook); }
+
+protected:
+    /**
+     * @brief 从输入源读取一个按键
+     * @param timeout_ms 超时时间(ms)，小于 0 表示一直等待，0 表示不等待
+     * @return 同 waitKeyDown(const int&)
+     */
+    virtual int readKey(const int &timeout_ms) = 0;
+
+private:
+    // 被放回的按键
+    std::deque<int> pending_keys;
+    // 等待输入之前调用
+    std::function<void()> idle_hook;
+};
@@ -0,0 +1,24 @@
+/**
+ * @file Log.h
+ * @details 日志前端，推荐使用 GAME_LOG 代替直接调用 Controller::log
+ */
+#pragma once
+#include "Controller.h"
+
+/**
+ * @brief 记录一条日志
+ * @details 用法：GAME_LOG(DEBUG, "NPCid: " + std::to_string(NPCid));\n
+ *          1. 等级低于编译期等级（OUCSurvSim_LOG_MIN_LEVEL）的调用在编译期被
+ *             if constexpr 丢弃，不会生成任何代码\n
+ *          2. 运行时被过滤的调用只有一次原子读和一次分支，消息表达式不会被求值，
+ *             因此也不会构造任何字符串
+ * @param LEVEL Controller::LogLevel 中的枚举名：DEBUG, INFO, WARN, ERR
+ * @note 消息表达式只在需要时才求值，不要在里面写有副作用的代码
+ */
+#define GAME_LOG(LEVEL, ...)                                                        \
+    do {                                                                            \
+        if constexpr (Controller::compiledIn(Controller::LogLevel::LEVEL)) {        \
+            if (Controller::enabled(Controller::LogLevel::LEVEL))                   \
+                Controller::getInstance()->log(Controller::LogLevel::LEVEL, (__VA_ARGS__)); \
+        }                                                                           \
+    } while (0)
@@ -0,0 +1,126 @@
+/**
+ * @file LogSink.cpp
+ */
+#include "LogSink.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    // 所有存活的 LogSink，供 atexit 使用
+    std::mutex sinks_mutex;
+    std::vector<LogSink *> live_sinks;
+}
+
+LogSink::LogSink(const std::filesystem::path &log_dir, const size_t &capacity):
+    queue(capacity) {
+    const std::string *names[FILE_NUM] = {&DEBUG_FILE, &INFO_FILE, &WARN_FILE, &ERROR_FILE};
+    for (int i = 0; i < FILE_NUM; ++i) {
+        files[i].open(log_dir / *names[i], std::ios::app);
+        buffers[i].reserve(16 * 1024);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        static const bool registered = (std::atexit(&LogSink::flushAll) == 0);
+        (void)registered;
+        live_sinks.push_back(this);
+    }
+    worker = std::thread(&LogSink::run, this);
+}
+
+LogSink::~LogSink() {
+    {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        live_sinks.erase(std::remove(live_sinks.begin(), live_sinks.end(), this), live_sinks.end());
+    }
+    stopping.store(true);
+    notifyWorker();
+    if (worker.joinable()) worker.join();
+}
+
+void LogSink::flushAll() {
+    std::lock_guard<std::mutex> lock(sinks_mutex);
+    for (auto sink : live_sinks) {
+        sink->flush();
+    }
+}
+
+void LogSink::write(const uint8_t &targets, std::string msg) {
+    if (!targets) return;
+    Record record{targets, std::move(msg)};
+    submitted.fetch_add(1, std::memory_order_acq_rel);
+    // 队列满时让出 CPU 等待后台线程消费，保证不丢记录
+    while (!queue.tryPush(std::move(record))) {
+        notifyWorker();
+        std::this_thread::yield();
+    }
+    if (sleeping.load()) {
+        notifyWorker();
+    }
+}
+
+void LogSink::flush() {
+    uint64_t target = submitted.load(std::memory_order_acquire);
+    if (written.load(std::memory_order_acquire) >= target) return;
+    if (std::this_thread::get_id() == worker.get_id()) return;
+    notifyWorker();
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&] {
+        return written.load(std::memory_order_acquire) >= target;
+    });
+}
+
+void LogSink::notifyWorker() {
+    std::lock_guard<std::mutex> lock(mutex);
+    wake_cv.notify_one();
+}
+
+size_t LogSink::drainBatch() {
+    Record record;
+    size_t count = 0;
+    while (count < BATCH_SIZE && queue.tryPop(record)) {
+        for (int i = 0; i < FILE_NUM; ++i) {
+            if (record.targets & (1 << i)) {
+                buffers[i] += record.msg;
+                buffers[i] += '\n';
+            }
+        }
+        ++count;
+    }
+    if (!count) return 0;
+
+    for (int i = 0; i < FILE_NUM; ++i) {
+        if (buffers[i].empty()) continue;
+        files[i].write(buffers[i].data(), static_cast<std::streamsize>(buffers[i].size()));
+        files[i].flush();
+        buffers[i].clear();
+    }
+    batches.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        written.fetch_add(count, std::memory_order_acq_rel);
+    }
+    done_cv.notify_all();
+    return count;
+}
+
+void LogSink::run() {
+    while (true) {
+        if (drainBatch()) continue;
+        if (stopping.load()) {
+            // 生产者可能在最后一次检查之后又提交了记录
+            while (drainBatch()) {}
+            break;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.store(true);
+        // 超时只是兜底，正常情况下由生产者唤醒
+        wake_cv.wait_for(lock, std::chrono::milliseconds(100), [&] {
+            return !queue.empty() || stopping.load();
+        });
+        sleeping.store(false);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    done_cv.notify_all();
+}
@@ -0,0 +1,119 @@
+/**
+ * @file LogSink.h
+ * @details 日志落盘模块，供 Controller::log 使用
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "BoundedQueue.h"
+
+/**
+ * @brief 异步日志落盘
+ * @details 四个日志文件在整个进程生命周期内保持打开，日志记录通过有界无锁队列
+ *          交给后台线程，后台线程把一批记录拼接好之后每个文件只写一次\n
+ *          队列满时生产者会等待后台线程腾出空间，因此不会丢失记录
+ * @note flush() 会阻塞到调用前提交的记录全部落盘，Controller 在 gameExit
+ *       和退出游戏时调用；进程通过 exit() 退出时也会自动 flush
+ */
+class LogSink {
+public:
+    /**
+     * @brief 日志文件，可以按位组合
+     */
+    enum Target : uint8_t {
+        DEBUG_LOG = 1 << 0, ///< Debug.log
+        INFO_LOG  = 1 << 1, ///< Info.log
+        WARN_LOG  = 1 << 2, ///< Warnings.log
+        ERROR_LOG = 1 << 3  ///< Error.log
+    };
+
+    /**
+     * @brief 打开所有日志文件并启动后台线程
+     * @param log_dir 日志目录
+     * @param capacity 队列容量
+     */
+    explicit LogSink(const std::filesystem::path &log_dir, const size_t &capacity = 4096);
+
+    /**
+     * @brief 析构函数，写完队列中剩余的记录后停止后台线程
+     */
+    ~LogSink();
+
+    LogSink(const LogSink &) = delete;
+    LogSink &operator=(const LogSink &) = delete;
+
+    /**
+     * @brief 提交一条日志
+     * @param targets 需要写入的文件，Target 的组合
+     * @param msg 日志消息，不含换行符
+     */
+    void write(const uint8_t &targets, std::string msg);
+
+    /**
+     * @brief 等待所有已提交的记录写入文件
+     */
+    void flush();
+
+    /**
+     * @brief flush 所有存活的 LogSink
+     * @note 注册在 atexit 中，exit() 时不需要手动调用
+     */
+    static void flushAll();
+
+    /**
+     * @brief 已经写入文件的记录数
+     */
+    uint64_t writtenCount() const { return written.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 后台线程执行 write 系统调用的批次数
+     */
+    uint64_t batchCount() const { return batches.load(std::memory_order_relaxed); }
+
+    inline static const std::string DEBUG_FILE = "Debug.log";
+    inline static const std::string INFO_FILE = "Info.log";
+    inline static const std::string WARN_FILE = "Warnings.log";
+    inline static const std::string ERROR_FILE = "Error.log";
+
+private:
+    static constexpr int FILE_NUM = 4;
+    // 后台线程一次最多处理的记录数
+    static constexpr size_t BATCH_SIZE = 512;
+
+    struct Record {
+        uint8_t targets = 0;
+        std::string msg;
+    };
+
+    BoundedQueue<Record> queue;
+    std::array<std::ofstream, FILE_NUM> files;
+    // 每个文件一个拼接缓冲区，只由后台线程使用
+    std::array<std::string, FILE_NUM> buffers;
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+
+    std::mutex mutex;
+    std::condition_variable wake_cv;
+    std::condition_variable done_cv;
+    std::thread worker;
+
+    // 后台线程主循环
+    void run();
+
+    // 从队列中取出一批记录并写入文件，返回处理的记录数
+    size_t drainBatch();
+
+    // 唤醒后台线程
+    void notifyWorker();
+};
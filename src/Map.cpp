@@ -4,19 +4,88 @@
  */
 #include "Map.h"
 #include "Controller.h"
+#include "Log.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <cctype>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <algorithm>
 #include <filesystem>
+#include <type_traits>
+#include <vector>
 #include "tools.h"
 
-Map::Map(const std::string &filename, const Position &pos) : modified(false),
-                                                             map(), x(-1), y(-1) {
+namespace {
+    // 二进制地图文件的格式：文件头，之后依次为前 rows 行的地图字符、碰撞网格、实体索引，
+    // 出口、入口、NPC、器械的坐标，最后是所有实体
+    constexpr char COMPILED_MAGIC[8] = {'O', 'U', 'C', 'M', 'A', 'P', '\0', '\0'};
+    // 2: 地形中不再保存主角的 '1'
+    constexpr uint32_t COMPILED_VERSION = 2;
+
+    struct CompiledHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t max_cols;      // MAX_WIDTH，数组尺寸改变后旧文件失效
+        uint32_t max_rows;      // MAX_HEIGHT
+        uint32_t cell_size;     // 碰撞网格每格的字节数
+        uint64_t source_size;   // 文本文件的大小
+        int64_t source_time;    // 文本文件的修改时间
+        int32_t max_width;
+        int32_t max_height;
+        int32_t x;
+        int32_t y;
+        uint32_t rows;          // 保存的行数，之后的行都是空的
+        uint32_t exits;
+        uint32_t entries;
+        uint32_t npcs;
+        uint32_t instruments;
+        uint32_t entities;
+    };
+    static_assert(sizeof(CompiledHeader) == 80, "CompiledHeader should stay packed");
+
+    struct CompiledEntity {
+        int32_t type, id, code, x, y, width, height;
+    };
+
+    // 文本文件的大小和修改时间，用于判断二进制文件是否过期
+    bool sourceStamp(const std::filesystem::path& path, uint64_t& size, int64_t& time) {
+        std::error_code error;
+        size = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+        auto write_time = std::filesystem::last_write_time(path, error);
+        if (error)
+            return false;
+        time = static_cast<int64_t>(write_time.time_since_epoch().count());
+        return true;
+    }
+
+    std::filesystem::path compiledPath(const std::string& map_path) {
+        return std::filesystem::path(map_path).replace_extension(".bin");
+    }
+
+    // 未加载任何地图时使用的地形，所有 Map 共享一份
+    const std::shared_ptr<const Map::Terrain>& emptyTerrain() {
+        static const auto empty = std::make_shared<const Map::Terrain>();
+        return empty;
+    }
+}
+
+Map::Map() : terrain(emptyTerrain()) {}
+
+Map::Map(const std::string &filename, const Position &pos) : modified(false), x(-1), y(-1) {
     // 这个地方被搞到了，由于我是在测试中写了很多次 Map，而释放 Map 再创建一个
     // Map 的对象时，C++ 让 map 数组重新使用了原来的内存区域，巧合的导致了一些
-    // 没有赋值的地方储存了旧的垃圾值，导致程序出现了异常判断，因此需要在初始
-    // 化列表中对 map 进行默认初始化
-    Message load_msg = loadMap(filename);
+    // 没有赋值的地方储存了旧的垃圾值，导致程序出现了异常判断，因此每次加载都
+    // 使用一份新的、默认初始化的地形
+    auto loaded = std::make_shared<Terrain>();
+    Message load_msg = use_compiled ? loadCompiled(*loaded, filename) : Message("未启用二进制地图", 1);
+    loaded->compiled = load_msg.status == 0;
+    // loadCompiled 检查通过之后才写入地形，失败时地形仍是空的
+    if (!loaded->compiled)
+        load_msg = loadMap(*loaded, filename);
     if (load_msg.status) {
         this->is_valid = false;
         this->valid_msg = load_msg.msg;
@@ -24,13 +93,18 @@ Map::Map(const std::string &filename, const Position &pos) : modified(false),
         this->is_valid = true;
         this->valid_msg = "";
     }
-    if (pos.x != -1 && pos.y != -1) {
-        this->x = pos.x;
-        this->y = pos.y;
-        map[this->x][this->y] = '1';
-    } else {
-        map[x][y] = '1';
-    }
+    // 二进制文件中已经保存了碰撞网格
+    if (is_valid && !loaded->compiled)
+        loaded->buildCollisionGrid();
+    terrain = std::move(loaded);
+    placeProtagonist(pos);
+}
+
+Map::Map(std::shared_ptr<const Terrain> terrain, const Position &pos)
+    : is_valid(terrain != nullptr), terrain(terrain ? std::move(terrain) : emptyTerrain()) {
+    if (!is_valid)
+        valid_msg = "没有地形";
+    placeProtagonist(pos);
 }
 
 Map::~Map() {
@@ -49,17 +123,251 @@ const std::string& Map::getValidMsg() const {
     return valid_msg;
 }
 
+Position Map::getErrorPos() const {
+    return error_pos;
+}
+
 
 Position Map::getPos() const {
     return {x, y};
 }
 
+void Map::placeProtagonist(const Position &pos) {
+    // 主角不写入地形，只修改自己的坐标
+    if (pos.x != -1 && pos.y != -1) {
+        x = pos.x;
+        y = pos.y;
+    } else {
+        x = terrain->spawn.x;
+        y = terrain->spawn.y;
+    }
+}
+
+std::shared_ptr<const Map::Terrain> Map::getTerrain() const {
+    return is_valid ? terrain : nullptr;
+}
+
 int Map::getMaxWidth() const {
-    return max_width;
+    return terrain->max_width;
 }
 
 int Map::getMaxHeight() const {
-    return max_height;
+    return terrain->max_height;
+}
+
+bool Map::isCompiled() const {
+    return terrain->compiled;
+}
+
+void Map::useCompiled(const bool& enable) {
+    use_compiled = enable;
+}
+
+Message Map::compile(const std::string& filename, size_t& bytes) {
+    bytes = 0;
+    Map loader;
+    auto loaded = std::make_unique<Terrain>();
+    Message msg = loader.loadMap(*loaded, filename);
+    if (msg.status)
+        return {filename + ": " + msg.msg, -1};
+    loaded->buildCollisionGrid();
+    return loaded->writeCompiled(bytes);
+}
+
+Message Map::lint(const std::filesystem::path& path, Position& where, const bool& compile) {
+    Map loader;
+    auto loaded = std::make_unique<Terrain>();
+    Message msg = loader.loadFile(*loaded, path);
+    where = loader.error_pos;
+    if (msg.status || !compile)
+        return msg;
+    loaded->buildCollisionGrid();
+    size_t bytes = 0;
+    return loaded->writeCompiled(bytes);
+}
+
+Message Map::loadCompiled(Terrain& t, const std::string& filename) {
+    for (const auto& ch : filename)
+        if (ch == '/' || ch == '\\') return {"非法文件名", -1};
+    std::string path = (Controller::getInstance()->getRootDir() / "maps" / filename).string();
+    uint64_t source_size = 0;
+    int64_t source_time = 0;
+    if (!sourceStamp(path, source_size, source_time))
+        return {"无法读取: " + path, 1};
+    MappedFile file(compiledPath(path));
+    if (!file.valid() || file.size() < sizeof(CompiledHeader))
+        return {"没有二进制地图", 1};
+
+    // 先检查文件头和总长度，确认无误之后才写入地形
+    CompiledHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) != 0 ||
+        header.version != COMPILED_VERSION ||
+        header.max_cols != MAX_WIDTH || header.max_rows != MAX_HEIGHT ||
+        header.cell_size != sizeof(CollisionCell))
+        return {"二进制地图格式不符", 1};
+    if (header.source_size != source_size || header.source_time != source_time)
+        return {"二进制地图已过期", 1};
+    if (header.rows > MAX_HEIGHT || header.max_height <= 0 || header.max_height > MAX_HEIGHT ||
+        header.max_width <= 0 || header.max_width > MAX_WIDTH || header.x < 0 || header.x >= MAX_HEIGHT ||
+        header.y < 0 || header.y >= MAX_WIDTH || header.entities > MAX_HEIGHT * MAX_WIDTH)
+        return {"二进制地图已损坏", 1};
+    size_t cells = static_cast<size_t>(header.rows) * MAX_WIDTH;
+    uint64_t positions = static_cast<uint64_t>(header.exits) + header.entries + header.npcs + header.instruments;
+    uint64_t expected = sizeof(CompiledHeader) + cells * (sizeof(char) + sizeof(CollisionCell) + sizeof(int16_t)) +
+                        positions * 2 * sizeof(int32_t) + header.entities * sizeof(CompiledEntity);
+    if (file.size() != expected)
+        return {"二进制地图已损坏", 1};
+
+    // 碰撞网格和实体索引会被直接用作下标，复制之前先在映射的文件中检查取值范围，越界的文件按损坏处理
+    const uint8_t* grid = file.data() + sizeof(CompiledHeader) + cells * sizeof(char);
+    const uint8_t* slots = grid + cells * sizeof(CollisionCell);
+    auto validExit = [](const char& exit) { return exit == -1 || exit == 'o' || exit == 'i'; };
+    for (size_t i = 0; i < cells; ++i) {
+        CollisionCell cell;
+        int16_t slot;
+        std::memcpy(&cell, grid + i * sizeof(CollisionCell), sizeof(cell));
+        std::memcpy(&slot, slots + i * sizeof(int16_t), sizeof(slot));
+        const int tile = char2index(cell.tile);
+        if ((cell.tile != -1 && cell.tile != -2 && (tile < 0 || tile >= CHAR_MAXN)) ||
+            !validExit(cell.vertical_exit) || !validExit(cell.horizontal_exit) ||
+            cell.exit_id < -1 || (cell.exit_id >= 0 && static_cast<uint32_t>(cell.exit_id) >= header.exits) ||
+            slot < 0 || static_cast<uint32_t>(slot) > header.entities)
+            return {"二进制地图已损坏", 1};
+    }
+    auto inMap = [](const int32_t& x, const int32_t& y) {
+        return x >= 0 && x < MAX_HEIGHT && y >= 0 && y < MAX_WIDTH;
+    };
+    const uint8_t* records = slots + cells * sizeof(int16_t);
+    for (uint64_t i = 0; i < positions; ++i) {
+        int32_t xy[2];
+        std::memcpy(xy, records + i * sizeof(xy), sizeof(xy));
+        if (!inMap(xy[0], xy[1]))
+            return {"二进制地图已损坏", 1};
+    }
+    records += positions * 2 * sizeof(int32_t);
+    for (uint32_t i = 0; i < header.entities; ++i) {
+        CompiledEntity entity;
+        std::memcpy(&entity, records + i * sizeof(CompiledEntity), sizeof(entity));
+        // 实体的 ID 是同类实体列表中的下标
+        uint32_t count = 0;
+        switch (entity.type) {
+            case static_cast<int32_t>(EntityType::EXIT): count = header.exits; break;
+            case static_cast<int32_t>(EntityType::ENTRY): count = header.entries; break;
+            case static_cast<int32_t>(EntityType::NPC): count = header.npcs; break;
+            case static_cast<int32_t>(EntityType::INSTRUMENT): count = header.instruments; break;
+            default: return {"二进制地图已损坏", 1};
+        }
+        if (entity.id < 0 || static_cast<uint32_t>(entity.id) >= count || !inMap(entity.x, entity.y) ||
+            entity.width < 1 || entity.width > 4 || entity.height < 1 || entity.height > 2)
+            return {"二进制地图已损坏", 1};
+    }
+
+    const uint8_t* cursor = file.data() + sizeof(CompiledHeader);
+    std::memcpy(&t.map[0][0], cursor, cells * sizeof(char));
+    cursor += cells * sizeof(char);
+    static_assert(std::is_trivially_copyable_v<CollisionCell>, "CollisionCell is copied as raw bytes");
+    std::memcpy(&t.collision[0][0], cursor, cells * sizeof(CollisionCell));
+    cursor += cells * sizeof(CollisionCell);
+    std::memcpy(&t.entity_at[0][0], cursor, cells * sizeof(int16_t));
+    cursor += cells * sizeof(int16_t);
+    auto readPositions = [&cursor](std::vector<Position>& list, const uint32_t& count) {
+        list.clear();
+        list.reserve(count);
+        for (uint32_t i = 0; i < count; ++i, cursor += 2 * sizeof(int32_t)) {
+            int32_t xy[2];
+            std::memcpy(xy, cursor, sizeof(xy));
+            list.emplace_back(xy[0], xy[1]);
+        }
+    };
+    readPositions(t.exits, header.exits);
+    readPositions(t.entries, header.entries);
+    readPositions(t.npcs, header.npcs);
+    readPositions(t.instruments, header.instruments);
+    t.entities.clear();
+    t.entities.reserve(header.entities);
+    for (uint32_t i = 0; i < header.entities; ++i, cursor += sizeof(CompiledEntity)) {
+        CompiledEntity entity;
+        std::memcpy(&entity, cursor, sizeof(entity));
+        t.entities.push_back({static_cast<EntityType>(entity.type), entity.id, static_cast<char>(entity.code),
+                            {entity.x, entity.y}, entity.width, entity.height});
+    }
+
+    t.path = path;
+    t.max_width = header.max_width;
+    t.max_height = header.max_height;
+    t.spawn = {header.x, header.y};
+    is_empty = false;
+    return {"", 0};
+}
+
+Message Map::Terrain::writeCompiled(size_t& bytes) const {
+    CompiledHeader header = {};
+    std::memcpy(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+    header.version = COMPILED_VERSION;
+    header.max_cols = MAX_WIDTH;
+    header.max_rows = MAX_HEIGHT;
+    header.cell_size = sizeof(CollisionCell);
+    if (!sourceStamp(path, header.source_size, header.source_time))
+        return {"无法读取: " + path, -1};
+    header.max_width = max_width;
+    header.max_height = max_height;
+    header.x = spawn.x;
+    header.y = spawn.y;
+    // 只保存有内容的行
+    for (int i = MAX_HEIGHT - 1; i >= 0 && !header.rows; --i)
+        for (int j = 0; j < MAX_WIDTH && !header.rows; ++j)
+            if (map[i][j])
+                header.rows = static_cast<uint32_t>(i + 1);
+    header.exits = static_cast<uint32_t>(exits.size());
+    header.entries = static_cast<uint32_t>(entries.size());
+    header.npcs = static_cast<uint32_t>(npcs.size());
+    header.instruments = static_cast<uint32_t>(instruments.size());
+    header.entities = static_cast<uint32_t>(entities.size());
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t cells = static_cast<size_t>(header.rows) * MAX_WIDTH;
+    out.append(&map[0][0], cells * sizeof(char));
+    out.append(reinterpret_cast<const char*>(&collision[0][0]), cells * sizeof(CollisionCell));
+    out.append(reinterpret_cast<const char*>(&entity_at[0][0]), cells * sizeof(int16_t));
+    for (const auto* list : {&exits, &entries, &npcs, &instruments}) {
+        for (const auto& pos : *list) {
+            int32_t xy[2] = {pos.x, pos.y};
+            out.append(reinterpret_cast<const char*>(xy), sizeof(xy));
+        }
+    }
+    for (const auto& entity : entities) {
+        CompiledEntity record {static_cast<int32_t>(entity.type), entity.id, entity.code,
+                               entity.pos.x, entity.pos.y, entity.width, entity.height};
+        out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+
+    // 先写入临时文件再替换，正在加载的进程不会读到写了一半的文件
+    std::filesystem::path target = compiledPath(path), temp = target;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return {"无法写入: " + temp.string(), -1};
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file)
+            return {"写入失败: " + temp.string(), -1};
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, target, error);
+    if (error)
+        return {"无法写入: " + target.string(), -1};
+    bytes = out.size();
+    return {"Success", 0};
+}
+
+uint64_t Map::getRevision() const {
+    return terrain->revision;
+}
+
+uint64_t Map::nextRevision() {
+    static std::atomic<uint64_t> counter {0};
+    return ++counter;
 }
 
 /**
@@ -77,34 +385,81 @@ Message Map::moveProtagonist(const int &direction, EventType &event_type, int &i
         case -2:    // 墙壁/空间狭小
             event_type = EventType::NONE;
             id = -1;
-            Controller::getInstance()->log(Controller::LogLevel::DEBUG, "墙壁/空间狭小");
+            GAME_LOG(DEBUG, "墙壁/空间狭小");
             return {"不可通行：墙壁/空间狭小", 1};
             break;
         case -1:    // 普通移动
-            map[x][y] = ' ';
             x += DIRECTIONS[direction][0];
             y += DIRECTIONS[direction][1];
-            map[x][y] = '1';
-            Controller::getInstance()->log(Controller::LogLevel::DEBUG, "普通移动");
+            GAME_LOG(DEBUG, "普通移动");
         case 'i':
             event_type = EventType::NONE;
             id = -1;
-            Controller::getInstance()->log(Controller::LogLevel::DEBUG, "i");
+            GAME_LOG(DEBUG, "i");
             return {"Success", 0};
         case 'o':
             event_type = EventType::JUMP;
-            id = getExitId({x + DIRECTIONS[direction][0], y + DIRECTIONS[direction][1]});
-            Controller::getInstance()->log(Controller::LogLevel::DEBUG, "e");
+            id = terrain->collision[x + DIRECTIONS[direction][0]][y + DIRECTIONS[direction][1]].exit_id;
+            GAME_LOG(DEBUG, "e");
             return {"抵达出口", 0};
         default:
             event_type = EventType::AC_INST;
             id = back_code;
-            Controller::getInstance()->log(Controller::LogLevel::DEBUG, "default");
+            GAME_LOG(DEBUG, "default");
             return {"与器械交互", 0};
     }
     return {"", 0};
 }
 
+Message Map::goTo(const int &ind, const int &type, std::vector<int> &directions) const {
+    directions.clear();
+    if (!is_valid)
+        return {"地图无效", -1};
+    EntityType target_type;
+    switch (type) {
+        case 0: target_type = EntityType::NPC; break;
+        case 1: target_type = EntityType::INSTRUMENT; break;
+        case 2: target_type = EntityType::EXIT; break;
+        default: return {"未知的目标类别", -1};
+    }
+    const auto& entities = terrain->entities;
+    int index = 0;
+    while (index < static_cast<int>(entities.size()) &&
+           (entities[index].type != target_type || entities[index].id != ind))
+        ++index;
+    if (index == static_cast<int>(entities.size()))
+        return {"目标不存在", -1};
+
+    const int width = terrain->max_width;
+    if (x < 0 || x >= terrain->max_height || y < 0 || y >= width)
+        return {"Bad position", -1};
+    auto field = terrain->distanceTo(index);
+    const auto& dist = *field;
+    Position at {x, y};
+    if (dist[at.x * width + at.y] == Terrain::UNREACHABLE)
+        return {"无法到达目标", -1};
+    // 每一步都走到距离少 1 的格子上，最后一步撞上目标
+    for (uint16_t left = dist[at.x * width + at.y]; left > 1; --left) {
+        for (int direction = 0; direction < 4; ++direction) {
+            Position next {at.x + DIRECTIONS[direction][0], at.y + DIRECTIONS[direction][1]};
+            if (next.x < 0 || next.x >= terrain->max_height || next.y < 0 || next.y >= width ||
+                dist[next.x * width + next.y] != left - 1 || !terrain->passable(next, direction % 2 == 0))
+                continue;
+            directions.push_back(direction);
+            at = next;
+            break;
+        }
+    }
+    for (int direction = 0; direction < 4; ++direction) {
+        Position next {at.x + DIRECTIONS[direction][0], at.y + DIRECTIONS[direction][1]};
+        if (terrain->collidedEntity(next, direction % 2 == 0) == &entities[index]) {
+            directions.push_back(direction);
+            break;
+        }
+    }
+    return {"Success", 0};
+}
+
 Message Map::save() const {
     /*
     std::ofstream map_file(map_path.c_str());
@@ -131,6 +486,39 @@ Message Map::save() const {
 }
 
 char Map::detectCollision(const Position& pos) const {
+    if (pos.x < 0 || pos.x >= MAX_HEIGHT || pos.y < 0 || pos.y >= MAX_WIDTH)
+        return -2;
+    const CollisionCell& cell = terrain->collision[pos.x][pos.y];
+    if (cell.tile != -1)
+        return cell.tile;
+    return pos.x != x ? cell.vertical_exit : cell.horizontal_exit;
+}
+
+void Map::Terrain::buildCollisionGrid() {
+    // 只有地图范围内的格子可能到达，其余保持为墙壁；扫描时会读取右边一格，最后一列也保持为墙壁
+    int width = std::min(max_width, MAX_WIDTH - 1);
+    for (int i = 0; i < max_height; ++i) {
+        for (int j = 0; j < width; ++j) {
+            CollisionCell& cell = collision[i][j];
+            cell.vertical_exit = scanCollision({i, j}, true);
+            cell.horizontal_exit = scanCollision({i, j}, false);
+            // 墙壁和宽字符与方向无关，两次扫描的结果相同
+            if (cell.vertical_exit == cell.horizontal_exit && cell.vertical_exit != 'o' && cell.vertical_exit != 'i') {
+                cell.tile = cell.vertical_exit;
+                cell.vertical_exit = cell.horizontal_exit = -1;
+            } else {
+                cell.tile = -1;
+            }
+            cell.exit_id = static_cast<int8_t>(exitIdAt({i, j}));
+        }
+    }
+}
+
+char Map::scanCollision(const Position& pos, const bool& vertical) const {
+    return terrain->scanCollision(pos, vertical);
+}
+
+char Map::Terrain::scanCollision(const Position& pos, const bool& vertical) const {
     /* 检查是否碰壁或空间狭小 */
     if (map[pos.x][pos.y] == '#' || map[pos.x][pos.y + 1] == '#') return -2;
 
@@ -149,7 +537,7 @@ char Map::detectCollision(const Position& pos) const {
             ++st;
         }
     }
-    if (pos.x != x) {
+    if (vertical) {
         /* 检查是否到横的exit/entry */
         for (int i = std::max(0, pos.y - 3); i <= std::min(MAX_WIDTH, pos.y + SPECIAL_CHARS[1].width - 1); ++i) {
             if (map[pos.x][i] == 'o') {
@@ -165,19 +553,19 @@ char Map::detectCollision(const Position& pos) const {
         /* 检查是否到竖的exit/entry */
         for (int i = std::max(0, pos.x - 1); i <= pos.x; ++i) {
             if (map[i][pos.y] == 'o') {
-                if (i + 2 < MAX_WIDTH && map[i + 2][pos.y] == '#')
+                if (i + 2 < MAX_HEIGHT && map[i + 2][pos.y] == '#')
                     return 'o';
             }
             if (map[i][pos.y + 1] == 'o') {
-                if (i + 2 < MAX_WIDTH && map[i + 2][pos.y + 1] == '#')
+                if (i + 2 < MAX_HEIGHT && map[i + 2][pos.y + 1] == '#')
                     return 'o';
             }
             if (map[i][pos.y] == 'i') {
-                if (i + 2 < MAX_WIDTH && map[i + 2][pos.y] == '#')
+                if (i + 2 < MAX_HEIGHT && map[i + 2][pos.y] == '#')
                     return 'i';
             }
             if (map[i][pos.y + 1] == 'i') {
-                if (i + 2 < MAX_WIDTH && map[i + 2][pos.y + 1] == '#')
+                if (i + 2 < MAX_HEIGHT && map[i + 2][pos.y + 1] == '#')
                     return 'i';
             }
         }
@@ -187,7 +575,7 @@ char Map::detectCollision(const Position& pos) const {
 }
 
 
-Map::LineType Map::classifyLine(const std::string& line) {
+Map::LineType Map::classifyLine(Terrain& t, const std::string& line) {
     bool filled = true;
 
     if (line.length() > MAX_WIDTH) return LineType::OVER_SIZE;
@@ -197,7 +585,7 @@ Map::LineType Map::classifyLine(const std::string& line) {
         const auto& ch = line[i];
         if (ch == '#') {
             ++ num;
-            max_width = std::max(max_width, i + 1);
+            t.max_width = std::max(t.max_width, i + 1);
         } else if (ch == '\r') {
             /* Maybe some bad chars were typed in Windows. */
             return LineType::INVAILD_LINE;
@@ -218,12 +606,17 @@ Map::LineType Map::classifyLine(const std::string& line) {
     return LineType::WALL;
 }
 
-Message Map::loadMap(const std::string& filename) {
+Message Map::loadMap(Terrain& t, const std::string& filename) {
     // 检查文件路径
     for (const auto& ch : filename)
         if (ch == '/' || ch == '\\') return {"非法文件名", -1};
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG,(Controller::getInstance()->getRootDir() / "maps" /filename).string());
-    map_path = (Controller::getInstance()->getRootDir()  / "maps"/ filename).string();
+        GAME_LOG(DEBUG, (Controller::getInstance()->getRootDir() / "maps" /filename).string());
+    return loadFile(t, Controller::getInstance()->getRootDir() / "maps" / filename);
+}
+
+Message Map::loadFile(Terrain& t, const std::filesystem::path& path) {
+    const std::string map_path = t.path = path.string();
+    error_pos = {-1, -1};
     bool return_is_valid = false;
 
     // 获取当前路径
@@ -234,40 +627,52 @@ Message Map::loadMap(const std::string& filename) {
         return {"无法打开: " + map_path, -1};
     }
     std::string line;
-    // 清空空白符号
-    map_file >> std::ws;
+    // 清空空白符号，记下跳过的行数，报错时换算成文件中的行号
+    int line_no = 0;
+    while (std::isspace(map_file.peek()))
+        if (map_file.get() == '\n') ++line_no;
+    // 记录出错的位置，column 为 -1 表示整行
+    auto fail = [&](const std::string& msg, const int& column) {
+        error_pos = {line_no, column};
+        return Message(msg + "：第 " + std::to_string(line_no) + " 行" +
+                       (column > 0 ? "第 " + std::to_string(column) + " 列" : ""), -1);
+    };
     // 当 file 读到 EOF 时，eof_bit 会被置为1（好像是）, 这时(bool)file 也是 false
     // 当 file 读取到的字符串超出 str.max_size() 或没有读取到任何字符时，会将 fail 置为 1
     int rows = 0;
     while(std::getline(map_file, line)) {
+        ++line_no;
         // 读取行
-        LineType line_type = classifyLine(line);
+        LineType line_type = classifyLine(t, line);
+        int column = -1;
         switch (line_type) {
             case LineType::WALL:
-                if (rows >= MAX_HEIGHT) return {"尺寸超出最大限制", -1};
-                if (!line_copy(map[rows], line)) {
-                    return {"无效地图：含有非法字符", -1};
+                if (rows >= MAX_HEIGHT) return fail("尺寸超出最大限制", -1);
+                if (rows == 0) line_offset = line_no - 1;
+                column = line_copy(t.map[rows], line);
+                if (column != -1) {
+                    return fail("无效地图：含有非法字符", column + 1);
                 }
                 break;
             case LineType::EMPTY_LINE:
                 --rows;
                 break;
             case LineType::INVAILD_LINE:
-                return {"在classifyLine 中检测出：无效地图", -1};
+                return fail("在classifyLine 中检测出：无效地图", static_cast<int>(line.find_first_of("\r\n")) + 1);
             case LineType::OVER_SIZE:
-                return {"尺寸超出最大限制", -1};
+                return fail("尺寸超出最大限制", MAX_WIDTH + 1);
             default:
-                return {"未知异常：接收到 getline 返回的异常值", -1};
+                return fail("未知异常：接收到 getline 返回的异常值", -1);
         }
         ++rows;
         if (rows > MAX_HEIGHT)
-            return {"尺寸超出最大限制", -1};
+            return fail("尺寸超出最大限制", -1);
     }
-    max_height = 0;
-    for (int i = rows - 1; i >= 0 && !max_height; --i) {
+    t.max_height = 0;
+    for (int i = rows - 1; i >= 0 && !t.max_height; --i) {
         for (int j = 0; j < MAX_WIDTH; ++j) {
-            if (map[i][j] == '#') {
-                max_height = i + 1;
+            if (t.map[i][j] == '#') {
+                t.max_height = i + 1;
             }
         }
     }
@@ -276,35 +681,42 @@ Message Map::loadMap(const std::string& filename) {
     if (map_file.fail() && !map_file.eof())
         return {"读取错误", -1};
 
-    bool approved = processMap();
-    if (approved) {
-        // 设置出口和 NPC 的 Id
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG, "Load the fucking Map");
-        if (!indexInit(rows)) {
-            return {"地图索引建立，主角生成失败", -1};
-        }
-        return {"", 0};
-    } else return {"地图未封闭，宽字符放置不合理或未知异常", -1};
+    Message checked = processMap(t, rows, error_pos);
+    if (checked.status)
+        return checked;
+    // 设置出口和 NPC 的 Id
+    GAME_LOG(DEBUG, "Load the fucking Map");
+    if (!indexInit(t, rows)) {
+        return {"地图索引建立，主角生成失败", -1};
+    }
+    return {"", 0};
 }
 //haozhe tang
-bool Map::indexInit(const int& rows) {
+bool Map::indexInit(Terrain& t, const int& rows) {
     int times = std::min(MAX_HEIGHT, rows + 1);
     for (int i = 0; i < times; ++i) {
         for (int j = 0;j < MAX_WIDTH; ++ j) {
-            if (!map[i][j]) break;
-            if (map[i][j] == 'o') {
-                exits.emplace_back(i, j);
-            } else if (map[i][j] == 'i') {
-                entries.emplace_back(i, j);
-            } else if (map[i][j] == '9') {
-                npcs.emplace_back(i, j);
-            } else if (map[i][j] == '1') {
-                if (x != -1 || y != -1) {
+            const char ch = t.map[i][j];
+            if (!ch) break;
+            if (ch == 'o') {
+                t.addEntity(EntityType::EXIT, static_cast<int>(t.exits.size()), i, j);
+                t.exits.emplace_back(i, j);
+            } else if (ch == 'i') {
+                t.addEntity(EntityType::ENTRY, static_cast<int>(t.entries.size()), i, j);
+                t.entries.emplace_back(i, j);
+            } else if (ch == '9') {
+                t.addEntity(EntityType::NPC, static_cast<int>(t.npcs.size()), i, j);
+                t.npcs.emplace_back(i, j);
+            } else if (ch != ' ' && ch != '#' && ch != '1') {
+                t.addEntity(EntityType::INSTRUMENT, static_cast<int>(t.instruments.size()), i, j);
+                t.instruments.emplace_back(i, j);
+            } else if (ch == '1') {
+                if (t.spawn.x != -1 || t.spawn.y != -1) {
                     return false;
                 }
-                x = i;
-                y = j;
-                map[x][y] = ' ';
+                // 地形中不保留主角
+                t.spawn = {i, j};
+                t.map[i][j] = ' ';
             }
         }
     }
@@ -312,7 +724,7 @@ bool Map::indexInit(const int& rows) {
     return true;
 }
 
-bool Map::line_copy(char map_line[], const std::string& line) {
+int Map::line_copy(char map_line[], const std::string& line) {
     int len = std::min(MAX_WIDTH, static_cast<int>(line.length()));
     int i = 0;
     for (; i < len; ++i) {
@@ -322,154 +734,109 @@ bool Map::line_copy(char map_line[], const std::string& line) {
             line[i] == '#' || line[i] == ' ') {
             map_line[i] = line[i];
         } else {
-            return false;
+            return i;
         }
     }
     for (; i < MAX_WIDTH; ++i) {
         map_line[i] = ' ';
     }
-    return true;
-}
-
-bool Map::processMap() {
-    int sx = -1, sy = -1;
-    for (int i = 0; sx == -1 && i < MAX_HEIGHT; ++i)
-        for (int j = 0; j < MAX_WIDTH; ++j)
-            if (map[i][j] == '#') {
-                sx = i, sy = j;
-                break;
-            }
-
-    std::stringstream ss;
-    ss << "开始processMap: " << sx << " " << sy;
-    Controller::getInstance()->log(Controller::LogLevel::DEBUG, ss.str());
-    if (sx == -1 || sy == -1) {
-        return false;
-    }
-
-    int n = MAX_WIDTH * MAX_HEIGHT;
-    int x = sx, y = sy;
-    calcDir(x, y, true);
-    while(n--) {
-        if (x == sx && y == sy) return true;
-        if (!calcDir(x, y)) return false;
-    }
-    return false;
+    return -1;
 }
 
-bool Map::calcDir(int& x, int& y, const bool& reset) {
-    /* 代码逻辑混乱 orz，非必要勿动 */
-    static int horizon;       // 正为右
-    static int vertical;      // 正为下
-    if (reset) {
-        horizon = 1;
-        vertical = 0;
-    }
-
-    // 检查宽字符
-    if (vertical) {
-        if(!checkWideChar(x, y)) return false;
-    }
-
-    /* 按原有方向走 */
-    if (horizon && y + horizon >= 0 && y + horizon < MAX_WIDTH) {
-        // 无出口或入口
-        if (map[x][y + horizon] == '#') {
-            y += horizon;
-            return true;
-        } else {
-            bool flag = true;
-            int ty = y + horizon * (horizon + 5) % 5;
-            if (map[x][ty] == 'o' || map[x][ty] == 'i') {
-                for (int i = horizon * ((horizon * 2 + 5) % 5); i != 5 && i != 0; ++i) {
-                    ty = y + i;
-                    if (ty < 0 ||
-                        ty >= MAX_WIDTH ||
-                        map[x][ty] != ' ') {
-                        flag = false;
-                        break;
-                    }
+Message Map::processMap(const Terrain& t, const int& rows, Position& where) const {
+    const int height = std::min(rows, MAX_HEIGHT), width = t.max_width;
+    // 换算成文件中的行列号
+    auto at = [this, &where](const int& x, const int& y) {
+        where = {line_offset + x + 1, y + 1};
+        return "第 " + std::to_string(where.x) + " 行第 " + std::to_string(where.y) + " 列";
+    };
+    if (height <= 0 || width <= 0)
+        return {"无效地图：没有墙壁", -1};
+
+    // 四周各加一格边框，走到边框上就是走出了地图
+    const int stride = width + 2;
+    auto cell = [stride](const int& x, const int& y) { return (x + 1) * stride + y + 1; };
+    enum : uint8_t { OPEN, WALL, DOOR, REACHED, OUTSIDE };
+    std::vector<uint8_t> state(static_cast<size_t>(height + 2) * stride, OPEN);
+    std::fill(state.begin(), state.begin() + stride, OUTSIDE);
+    std::fill(state.end() - stride, state.end(), OUTSIDE);
+    for (int i = 0; i < height; ++i)
+        state[cell(i, -1)] = state[cell(i, width)] = OUTSIDE;
+    // 出入口的坐标以及是否为横向
+    std::vector<std::pair<Position, bool>> doors;
+    Position spawn {-1, -1};
+
+    // 从左到右扫描，宽字符右侧的格子如果属于出入口，此时已经标记好了
+    for (int i = 0; i < height; ++i) {
+        const char* row = t.map[i];
+        for (int j = 0; j < width; ++j) {
+            const char ch = row[j];
+            if (ch == ' ') {
+                continue;
+            } else if (ch == '#') {
+                state[cell(i, j)] = WALL;
+            } else if (ch == 'o' || ch == 'i') {
+                const bool horizontal = j >= 1 && j + 4 < MAX_WIDTH && row[j - 1] == '#' && row[j + 1] == ' ' &&
+                                        row[j + 2] == ' ' && row[j + 3] == ' ' && row[j + 4] == '#';
+                if (horizontal) {
+                    for (int k = 0; k < 4; ++k)
+                        state[cell(i, j + k)] = DOOR;
+                } else if (i >= 1 && i + 2 < height && t.map[i - 1][j] == '#' &&
+                           t.map[i + 1][j] == ' ' && t.map[i + 2][j] == '#') {
+                    state[cell(i, j)] = state[cell(i + 1, j)] = DOOR;
+                } else {
+                    return {"出入口必须是墙上宽 4 的横向缺口或高 2 的竖向缺口：" + at(i, j), -1};
                 }
-            } else flag = false;
-            if (flag) {
-                y += 4 * horizon;
-                return true;
+                doors.push_back({{i, j}, horizontal});
+            } else {
+                int index = char2index(ch);
+                if (index < 0 || index >= CHAR_MAXN)
+                    return {"无效地图：未知的特殊字符：" + at(i, j), -1};
+                // 宽字符会占用右侧的一格
+                if (SPECIAL_CHARS[index].width > 1 && j + 1 < MAX_WIDTH &&
+                    (row[j + 1] != ' ' || (j + 1 < width && state[cell(i, j + 1)] != OPEN)))
+                    return {"宽字符右侧必须留出一格空地：" + at(i, j), -1};
+                if (ch == '1' && spawn.x != -1)
+                    return {"主角出生点只能有一个：" + at(i, j), -1};
+                if (ch == '1')
+                    spawn = {i, j};
             }
         }
     }
-    if (vertical && x + vertical >= 0 && x + vertical < MAX_HEIGHT) {
-        // 无出口或入口
-        if (map[x + vertical][y] == '#') {
-            x += vertical;
-            return true;
-        } else {
-            bool flag = true;
-            int tx = x + vertical * (vertical + 3) % 3;
-            if (map[tx][y] == 'o' || map[tx][y] == 'i') {
-                if(!checkWideChar(tx, y)) {
-                    return false;
-                }
-                for (int i = vertical * ((vertical * 2 + 3) % 3); i != 3 && i != 0; ++i) {
-                    tx = x + i;
-                    if (tx < 0 ||
-                        tx >= MAX_WIDTH ||
-                        map[tx][y] != ' ') {
-                        flag = false;
-                        break;
-                    } else if(!checkWideChar(tx, y)) {
-                        return false;
-                    }
-                }
-            } else flag = false;
-            if (flag) {
-                x += 2 * vertical;
-                return true;
-            }
-        }
-    }
-
-    // 换方向
-    if (horizon) {
-        vertical = 0;
-        if (x >= 1 && map[x - 1][y] == '#') {
-            vertical -= 1;
-        }
-        if (x >= 2 && (map[x - 2][y] == 'i' || map[x - 2][y] == 'o')) {
-            vertical -= 1;
+    if (spawn.x == -1)
+        return {"无效地图：没有主角的出生点", -1};
+
+    // 从出生点开始的广度优先填充，第一次走到边框时所在的格子就是墙上的缺口
+    std::vector<int> queue;
+    queue.reserve(static_cast<size_t>(height) * width);
+    queue.push_back(cell(spawn.x, spawn.y));
+    state[queue.front()] = REACHED;
+    const int steps[4] = {-stride, 1, stride, -1};
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const int current = queue[head];
+        for (const int& step : steps) {
+            const int next = current + step;
+            if (state[next] == OUTSIDE)
+                return {"地图未封闭：" + at(current / stride - 1, current % stride - 1), -1};
+            if (state[next] != OPEN)
+                continue;
+            state[next] = REACHED;
+            queue.push_back(next);
         }
-        if (vertical < -1) return false;
-        if (x + 1 < MAX_HEIGHT && (map[x + 1][y] == 'i' || map[x + 1][y] == 'o' || map[x + 1][y] == '#')) {
-            vertical += 1;
-        }
-        if (!vertical) return false;
-        horizon = 0;
-        if (map[x + vertical][y] == '#') {
-            x += vertical;
-        }
-        return true;
     }
 
-    if (vertical) {
-        horizon = 0;
-        if (y >= 1 && map[x][y - 1] == '#') {
-            horizon -= 1;
-        }
-        if (y >= 4 && (map[x][y - 4] == 'i' || map[x][y - 4] == 'o')) {
-            horizon -= 1;
+    // 出入口至少有一格与出生点所在的区域相邻
+    for (const auto& [door, horizontal] : doors) {
+        bool touched = false;
+        for (int k = 0; k < (horizontal ? 4 : 2) && !touched; ++k) {
+            const int at = horizontal ? cell(door.x, door.y + k) : cell(door.x + k, door.y);
+            for (const int& step : steps)
+                touched = touched || state[at + step] == REACHED;
         }
-        if (horizon < -1) return false;
-        if (y + 1 < MAX_WIDTH && (map[x][y + 1] == 'i' || map[x][y + 1] == 'o' || map[x][y + 1] == '#')) {
-            horizon += 1;
-        }
-        if (!horizon) return false;
-        vertical = 0;
-        if (map[x][y + horizon] == '#') {
-            y += horizon;
-        }
-        return true;
+        if (!touched)
+            return {"出入口无法从出生点到达：" + at(door.x, door.y), -1};
     }
-
-    return false;
+    return {"", 0};
 }
 
 int Map::char2index(const char& ch) {
@@ -483,37 +850,151 @@ int Map::char2index(const char& ch) {
     return -1;
 }
 
-bool Map::checkWideChar(const int& x, const int& y) {
-    int index = -2;
-    if (map[x][y - 1] != ' ' && map[x][y - 1] != '#') {
-        index = char2index(map[x][y - 1]);
-    }
-    if (map[x][y + 1] != ' ' && map[x][y + 1] != '#') {
-        index = char2index(map[x][y + 1]);
+void Map::Terrain::addEntity(const EntityType& type, const int& id, const int& x, const int& y) {
+    Entity entity {type, id, map[x][y], {x, y}, 1, 1};
+    if (type == EntityType::EXIT || type == EntityType::ENTRY) {
+        // 与 View 绘制出入口时的判断一致
+        if (y >= 1 && y + 4 < MAX_WIDTH && map[x][y - 1] == '#' && map[x][y + 4] == '#')
+            entity.width = 4;
+        else if (x >= 1 && x + 2 < MAX_HEIGHT && map[x - 1][y] == '#' && map[x + 2][y] == '#')
+            entity.height = 2;
+    } else {
+        int index = char2index(map[x][y]);
+        if (index != -1 && SPECIAL_CHARS[index].width > 1)
+            entity.width = SPECIAL_CHARS[index].width;
     }
-    if (index != -2 && (index == -1 || SPECIAL_CHARS[index].width > 1)) return false;
-    return true;
+    entities.push_back(entity);
+    int16_t slot = static_cast<int16_t>(entities.size());
+    for (int i = x; i < x + entity.height && i < MAX_HEIGHT; ++i)
+        for (int j = y; j < y + entity.width && j < MAX_WIDTH; ++j)
+            if (!entity_at[i][j])
+                entity_at[i][j] = slot;
+}
+
+const Map::Entity* Map::entityAt(const Position& pos) const {
+    return terrain->entityAt(pos);
+}
+
+const Map::Entity* Map::Terrain::entityAt(const Position& pos) const {
+    if (pos.x < 0 || pos.x >= MAX_HEIGHT || pos.y < 0 || pos.y >= MAX_WIDTH || !entity_at[pos.x][pos.y])
+        return nullptr;
+    return &entities[entity_at[pos.x][pos.y] - 1];
+}
+
+std::vector<Map::Entity> Map::entitiesWithin(const Position& center, const int& radius) const {
+    std::vector<int> found;
+    if (radius < 0)
+        return {};
+    int top = std::max(0, center.x - radius), bottom = std::min(MAX_HEIGHT - 1, center.x + radius);
+    int left = std::max(0, center.y - radius), right = std::min(MAX_WIDTH - 1, center.y + radius);
+    const auto& entity_at = terrain->entity_at;
+    for (int i = top; i <= bottom; ++i)
+        for (int j = left; j <= right; ++j)
+            if (entity_at[i][j])
+                found.push_back(entity_at[i][j] - 1);
+    // 占用多个格子的实体只保留一次
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    std::vector<Entity> result;
+    result.reserve(found.size());
+    for (const auto& index : found)
+        result.push_back(terrain->entities[index]);
+    return result;
 }
 
-int Map::getExitId(const Position& pos) {
-    // 查找pos是否在出口列表中（考虑出口宽度4，高度2的范围）
-    for (size_t i = 0; i < exits.size(); ++i) {
-        const auto& exit_pos = exits[i];
-        // 出口区域：x在[exit_pos.x, exit_pos.x+1]，y在[exit_pos.y, exit_pos.y+3]
-        if (pos.x >= exit_pos.x && pos.x <= exit_pos.x + 1 &&
-            pos.y >= exit_pos.y && pos.y <= exit_pos.y + 3) {
-            return static_cast<int>(i);
+int Map::Terrain::exitIdAt(const Position& pos) const {
+    // 出口区域：x在[exit_pos.x, exit_pos.x+1]，y在[exit_pos.y, exit_pos.y+3]
+    // 因此只需要检查 pos 左上方 2x4 范围内的格子是否为出口字符，有多个时取 ID 最小的
+    int id = -1;
+    for (int i = std::max(0, pos.x - 1); i <= pos.x && i < MAX_HEIGHT; ++i) {
+        for (int j = std::max(0, pos.y - 3); j <= pos.y && j < MAX_WIDTH; ++j) {
+            const Entity* entity = entityAt({i, j});
+            if (entity && entity->type == EntityType::EXIT && entity->pos == Position(i, j) &&
+                (id == -1 || entity->id < id))
+                id = entity->id;
         }
     }
-    return -1;  // 未找到
+    return id;
 }
 
-int Map::getNPCId(const Position& pos) {
+int Map::Terrain::npcIdAt(const Position& pos) const {
     // 精确匹配NPC位置（NPC为单个字符）
-    for (size_t i = 0; i < npcs.size(); ++i) {
-        if (npcs[i].x == pos.x && npcs[i].y == pos.y) {
-            return static_cast<int>(i);
+    const Entity* entity = entityAt(pos);
+    if (entity && entity->type == EntityType::NPC && entity->pos == pos)
+        return entity->id;
+    return -1;  // 未找到
+}
+
+bool Map::Terrain::passable(const Position& pos, const bool& vertical) const {
+    if (pos.x < 0 || pos.x >= MAX_HEIGHT || pos.y < 0 || pos.y >= MAX_WIDTH)
+        return false;
+    const CollisionCell& cell = collision[pos.x][pos.y];
+    return cell.tile == -1 && (vertical ? cell.vertical_exit : cell.horizontal_exit) == -1;
+}
+
+const Map::Entity* Map::Terrain::collidedEntity(const Position& pos, const bool& vertical) const {
+    if (pos.x < 0 || pos.x >= MAX_HEIGHT || pos.y < 0 || pos.y >= MAX_WIDTH)
+        return nullptr;
+    const CollisionCell& cell = collision[pos.x][pos.y];
+    if (cell.tile == -1) {
+        // 与 moveProtagonist 一致，出口的 ID 取自碰撞网格
+        char exit = vertical ? cell.vertical_exit : cell.horizontal_exit;
+        if (exit != 'o' || cell.exit_id < 0 || cell.exit_id >= static_cast<int>(exits.size()))
+            return nullptr;
+        return entityAt(exits[cell.exit_id]);
+    }
+    if (cell.tile == -2)
+        return nullptr;
+    // 主角占 pos 和右边一格，撞上的宽字符一定占用了这两格之一
+    for (int j = pos.y; j <= pos.y + 1; ++j) {
+        const Entity* entity = entityAt({pos.x, j});
+        if (entity && entity->code == cell.tile)
+            return entity;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const Map::Terrain::DistanceField> Map::Terrain::distanceTo(const int& index) const {
+    {
+        std::lock_guard<std::mutex> guard(fields_lock);
+        auto it = fields.find(index);
+        if (it != fields.end())
+            return it->second;
+    }
+    // 搜索时不持有锁，两个线程同时建立同一个距离场时结果相同，保留先写入的一份
+    auto field = std::make_shared<DistanceField>(static_cast<size_t>(max_height) * max_width, UNREACHABLE);
+    auto& dist = *field;
+    const Entity* target = index >= 0 && index < static_cast<int>(entities.size()) ? &entities[index] : nullptr;
+    std::vector<Position> queue;
+    // 一步就能撞上目标的格子
+    for (int i = 0; i < max_height && target; ++i) {
+        for (int j = 0; j < max_width; ++j) {
+            for (int direction = 0; direction < 4; ++direction) {
+                Position next {i + DIRECTIONS[direction][0], j + DIRECTIONS[direction][1]};
+                if (collidedEntity(next, direction % 2 == 0) == target) {
+                    dist[i * max_width + j] = 1;
+                    queue.emplace_back(i, j);
+                    break;
+                }
+            }
         }
     }
-    return -1;  // 未找到
+    // 反向搜索：主角能从 prev 走到 current，则 prev 比 current 多一步
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const Position current = queue[head];
+        const uint16_t steps = dist[current.x * max_width + current.y];
+        for (int direction = 0; direction < 4; ++direction) {
+            if (!passable(current, direction % 2 == 0))
+                continue;
+            Position prev {current.x - DIRECTIONS[direction][0], current.y - DIRECTIONS[direction][1]};
+            if (prev.x < 0 || prev.x >= max_height || prev.y < 0 || prev.y >= max_width ||
+                dist[prev.x * max_width + prev.y] != UNREACHABLE)
+                continue;
+            dist[prev.x * max_width + prev.y] = steps + 1;
+            queue.push_back(prev);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(fields_lock);
+    return fields.try_emplace(index, std::move(field)).first->second;
 }
@@ -3,7 +3,13 @@
  * @author Jie Jiang
  * */
 #pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "tools.h"
 class Controller;
 class View;
@@ -19,6 +25,12 @@ class View;
  *          8. 要求地图尺寸不大于 100x50 （宽x高）
  *          9. 为了避免 Map 检测到地图尺寸异常，请不要在文件末尾添加空行
  *         10. 为了同时兼容 Linux 和 Windows, 地图路径只能是一个文件名，不能有任何 `/` 或 '\' 符号
+ *         11. maps/ 下有同名的 .bin 文件（由 `game compile-maps` 生成）且与文本文件一致时，直接加载该文件
+ *         12. 地图中必须有且只有一个主角出生点，出生点所在的区域必须被墙壁和出入口围住
+ *         13. 宽度为 2 的特殊字符右侧的一格必须是空地
+ *
+ *          地图分为两层：墙壁、出入口、NPC、器械等不会变化的内容放在只读的 Terrain 中，
+ *          由加载同一地图的多个 Map 共享；Map 本身只保存主角的坐标等每个会话各自的状态
  * @note 该类的重要原则应当是保证任何状态下 Map 类中的所有成员全部设置正确
  */
 
@@ -82,7 +94,134 @@ public:
      */
     constexpr static int PROTAGONIST_INDEX = 1;
 
-    Map() = default;
+    /**
+     * @brief 地图中的实体类别
+     */
+    enum class EntityType {
+        EXIT,       ///< 出口
+        ENTRY,      ///< 入口
+        NPC,        ///< NPC
+        INSTRUMENT  ///< 器械等其他特殊符号
+    };
+
+    /**
+     * @brief 地图中的一个实体
+     * @details 实体占用的格子：横向的出入口占 4 列，竖向的出入口占 2 行，其余实体占其符号宽度的列数
+     */
+    struct Entity {
+        EntityType type;  ///< 类别
+        int id;           ///< 同类实体中的编号，按从上到下、从左到右的顺序，与出口 ID、NPC ID 一致
+        char code;        ///< 地图文件中的字符
+        Position pos;     ///< 地图字符所在的坐标
+        int width;        ///< 占用的列数
+        int height;       ///< 占用的行数
+    };
+
+    /**
+     * @brief 碰撞网格中的一格
+     */
+    struct CollisionCell {
+        char tile = -2;            ///< 墙壁/空间狭小为 -2，宽字符器械或 NPC 为其字符，否则为 -1
+        char vertical_exit = -1;   ///< 上下移动到这里时碰到的出入口('o'/'i')，没有为 -1
+        char horizontal_exit = -1; ///< 左右移动到这里时碰到的出入口
+        int8_t exit_id = -1;       ///< 所在出口的 ID，不在出口中为 -1
+    };
+
+    /**
+     * @brief 一张地图中不会变化的部分
+     * @details 加载完成之后不再修改，通过 std::shared_ptr<const Terrain> 共享，多个线程可以同时读取\n
+     *          地形数组中不包含主角，主角的坐标由各个 Map 自己保存
+     */
+    struct Terrain {
+        std::string path;                                // 地图文件路径
+        char map[MAX_HEIGHT][MAX_WIDTH] = {};            // 地图数组
+        CollisionCell collision[MAX_HEIGHT][MAX_WIDTH];  // 碰撞网格，地图之外的格子都是墙壁
+        int16_t entity_at[MAX_HEIGHT][MAX_WIDTH] = {};   // 每个格子所属实体在 entities 中的下标加 1，0 表示没有
+        std::vector<Entity> entities;                    // 所有实体
+        std::vector<Position> exits;                     // 出口位置列表（ID为索引）
+        std::vector<Position> entries;                   // 入口位置列表
+        std::vector<Position> npcs;                      // NPC位置列表
+        std::vector<Position> instruments;               // 器械位置列表
+        int max_width = 0;                               // 地图最大宽度
+        int max_height = 0;                              // 地图最大高度
+        Position spawn {-1, -1};                         // 地图文件中的出生点
+        bool compiled = false;                           // 是否从二进制文件加载
+        uint64_t revision = nextRevision();              // 地形版本号
+
+        /**
+         * @brief 到某个实体的距离场
+         * @details 下标为 i * max_width + j，值为主角从 (i, j) 出发撞上该实体需要的步数，无法到达为 UNREACHABLE
+         */
+        using DistanceField = std::vector<uint16_t>;
+        constexpr static uint16_t UNREACHABLE = UINT16_MAX;
+
+        /**
+         * @brief 到 entities[index] 的距离场
+         * @details 第一次查询时从目标出发做一次广度优先搜索，之后直接返回缓存的结果；多个线程可以同时调用
+         * @param index 实体在 entities 中的下标
+         */
+        std::shared_ptr<const DistanceField> distanceTo(const int &index) const;
+
+        /**
+         * @brief 主角向 pos 移动一步时能否到达 pos，规则与 moveProtagonist 相同
+         * @param vertical 是否为上下移动
+         */
+        bool passable(const Position &pos, const bool &vertical) const;
+
+        /**
+         * @brief 主角向 pos 移动一步时撞上的出口、NPC 或器械
+         * @param vertical 是否为上下移动
+         * @return 没有撞上或撞上墙壁、入口时返回 nullptr
+         */
+        const Entity *collidedEntity(const Position &pos, const bool &vertical) const;
+
+        /**
+         * @brief 占用这个格子的实体，见 Map::entityAt
+         */
+        const Entity *entityAt(const Position &pos) const;
+
+        /**
+         * @brief 逐格扫描地图检查碰撞，见 Map::scanCollision
+         */
+        char scanCollision(const Position &pos, const bool &vertical) const;
+
+        /**
+         * @brief 获取出口 ID，不在出口中时返回 -1
+         */
+        int exitIdAt(const Position &pos) const;
+
+        /**
+         * @brief 获取 NPC ID，不是 NPC 时返回 -1
+         */
+        int npcIdAt(const Position &pos) const;
+
+        /**
+         * @brief 记录一个实体，并标记它占用的格子
+         */
+        void addEntity(const EntityType &type, const int &id, const int &x, const int &y);
+
+        /**
+         * @brief 建立碰撞网格
+         * @note 墙壁和出入口不会改变，主角不会与自己碰撞，因此网格只需要在加载地图时建立一次
+         */
+        void buildCollisionGrid();
+
+        /**
+         * @brief 把已经加载好的地图写入二进制文件
+         * @param[out] bytes 写入的字节数
+         */
+        Message writeCompiled(size_t &bytes) const;
+
+    private:
+        // 按实体下标缓存的距离场，地形的其余部分加载后不再修改，只有这里需要加锁
+        mutable std::mutex fields_lock;
+        mutable std::unordered_map<int, std::shared_ptr<const DistanceField>> fields;
+    };
+
+    /**
+     * @brief 空地图，valid() 为 false
+     */
+    Map();
     /**
      * @brief 使用地图文件初始化地图
      * @param filename String 类型
@@ -90,6 +229,14 @@ public:
      */
     Map(const std::string &filename, const Position &pos = {-1, -1});
 
+    /**
+     * @brief 在已经加载好的地形上开始一个新的会话
+     * @details 不读取文件，也不复制地形，只记录主角的坐标
+     * @param terrain 另一个有效的 Map 的 getTerrain()，为空时地图无效
+     * @param pos 主角的初始坐标，为 {-1, -1} 时使用出生点
+     */
+    explicit Map(std::shared_ptr<const Terrain> terrain, const Position &pos = {-1, -1});
+
     /**
      * @brief 析构函数，Map 应当将当前地图下的所有修改保存到文件中
      * @note 只有地图有效且地图被修改时才会进行保存, 通过析构函数来保存地图并不稳定,
@@ -110,12 +257,25 @@ public:
      */
     const std::string &getValidMsg() const;
 
+    /**
+     * @brief 地图加载失败时出错的位置
+     * @return 文件中的行号和列号（x 为行，y 为列，均从 1 开始），列号为 -1 表示整行，无法定位时为 {-1, -1}
+     */
+    Position getErrorPos() const;
+
     /**
      * @brief 获取主角当前坐标
      * @return a Position.
      */
     Position getPos() const;
 
+    /**
+     * @brief 把主角放到指定位置
+     * @details 清除主角原来的位置，用于场景切换时复用已经加载的地图
+     * @param pos 主角的新坐标，为 {-1, -1} 时回到地图文件中的出生点
+     */
+    void placeProtagonist(const Position &pos = {-1, -1});
+
     /**
      * @brief 获取地图最大宽度
      * @return a int
@@ -128,6 +288,52 @@ public:
      */
     int getMaxHeight() const;
 
+    /**
+     * @brief 是否从编译好的二进制文件加载
+     */
+    bool isCompiled() const;
+
+    /**
+     * @brief 把地图编译为二进制文件
+     * @details 按文本格式加载并检查地图，再把地形、碰撞网格和实体索引写入 maps/ 下同名的 .bin 文件，
+     *          文件中记录了文本文件的大小和修改时间，两者任一改变时二进制文件视为过期，加载时退回文本格式
+     * @param filename 地图文件名，规则与构造函数相同
+     * @param[out] bytes 写入的字节数
+     * @return Message，地图无效或写入失败时 status 为 -1
+     */
+    static Message compile(const std::string &filename, size_t &bytes);
+
+    /**
+     * @brief 按加载地图的规则检查任意路径下的地图文件
+     * @details 不读取二进制文件，也不要求文件位于 maps/ 下，供 `game lint-maps` 使用；
+     *          多个线程可以同时检查不同的文件
+     * @param path 地图文件路径
+     * @param[out] where 出错的位置，规则与 getErrorPos 相同
+     * @param compile 检查通过后是否在同一目录下写入二进制文件
+     * @return Message，地图无效或写入失败时 status 为 -1
+     */
+    static Message lint(const std::filesystem::path &path, Position &where, const bool &compile = false);
+
+    /**
+     * @brief 是否优先加载编译好的二进制文件，默认开启
+     * @details 关闭后总是解析文本地图，用于比较两者的加载时间
+     */
+    static void useCompiled(const bool &enable);
+
+    /**
+     * @brief 共享的地形
+     * @return 地图无效时为 nullptr
+     */
+    std::shared_ptr<const Terrain> getTerrain() const;
+
+    /**
+     * @brief 获取地形版本号
+     * @details 每份加载的地形的版本号都不相同，共享同一份地形的 Map 版本号相同，View 据此判断缓存的地形是否需要重新绘制\n
+     *          主角移动不改变地形；地形加载之后是只读的，需要修改时应当加载一份新的 Terrain
+     * @return a uint64_t
+     */
+    uint64_t getRevision() const;
+
     /**
      * @brief 移动主角
      * @param[in] direction 方向\n
@@ -152,20 +358,21 @@ public:
     Message moveProtagonist(const int &direction, EventType &event_type, int &id);
 
     /**
-     * @brief 传送主角到某一个地点
-     * @details 支持地图内传送到某个 NPC 的附近\n
-     *          一旦成功传送，应当建立一个坐标索引，减少搜索耗时\n
-     *          默认从该对象的下、右、上、左的顺序寻找空位\n
-     *          若无法找到空位，寻找从左到右，从上到下的第一个空位
-     *          TODO 尚未实现空位寻找
-     * @param ind 传送目的地（对象）的 ID 或索引
-     * @param type 传送对象的类别，器械旁/NPC旁/出口入口\n
+     * @brief 从主角当前位置走到某个出口、NPC 或器械的最短路线
+     * @details 在碰撞网格上按 moveProtagonist 的规则寻路，路线的最后一步撞上目标：出口触发 JUMP，
+     *          NPC 和器械触发 AC_INST\n
+     *          每个目标的距离场在第一次查询时建立并缓存在共享的地形中，之后的查询只沿步数递减的方向走，
+     *          耗时与路线长度成正比\n
+     *          只计算路线，不移动主角
+     * @param ind 目标的 ID，与 getEntities() 中同类实体的 id 一致
+     * @param type 目标的类别\n
      *        0: NPC
      *        1: 器械
      *        2: 出口
-     *        3: 入口
+     * @param[out] directions 每一步的方向，含义同 moveProtagonist
+     * @return Message，目标不存在或无法到达时 status 为 -1
      */
-    Message goTo(const int &ind, const int &type);
+    Message goTo(const int &ind, const int &type, std::vector<int> &directions) const;
 
     /**
      * @brief 保存当前地图到文件中
@@ -176,11 +383,22 @@ public:
     Message save() const;
     /**
      * @brief 检查这个坐标处是否有器械、NPC、出口
+     * @details 结果在加载地图时预先算好，这里只读取一次碰撞网格
      * @param pos Position，这个位置的坐标
      * @return a char index of SPECIAL_CHARS value, -1 表示未碰撞 -2 表示空间狭小/墙壁
      */
     char detectCollision(const Position &pos) const;
 
+    /**
+     * @brief 逐格扫描地图检查碰撞
+     * @details 用于建立碰撞网格，结果与 detectCollision 相同\n
+     *          出入口的判断与移动方向有关：上下移动时只检查横向的出入口，左右移动时只检查竖向的出入口
+     * @param pos 坐标
+     * @param vertical 是否为上下移动
+     * @return 同 detectCollision
+     */
+    char scanCollision(const Position &pos, const bool &vertical) const;
+
     /**
      * @brief 获取字符的 index
      * @param ch 字符
@@ -188,14 +406,29 @@ public:
      */
     static int char2index(const char &ch);
 
-private:
+    /**
+     * @brief 占用这个格子的实体
+     * @param pos 坐标
+     * @return 没有实体或坐标越界时返回 nullptr
+     */
+    const Entity *entityAt(const Position &pos) const;
+
+    /**
+     * @brief 与 center 的距离不超过 radius 的所有实体
+     * @details 距离按行列差的最大值计算，实体的任意一格满足条件即可；只检查 center 附近的格子，
+     *          与实体总数无关
+     * @param center 中心坐标
+     * @param radius 半径，小于 0 时返回空列表
+     * @return 按实体加载的顺序排列
+     */
+    std::vector<Entity> entitiesWithin(const Position &center, const int &radius) const;
 
-    // 新增：存储出口、入口、NPC位置（ID为索引）
-    //haozhe Tang
-    std::vector<Position> exits;    // 出口位置列表
-    std::vector<Position> entries;  // 入口位置列表
-    std::vector<Position> npcs;     // NPC位置列表
-    std::vector<Position> instruments;  // 器械位置列表（按SPECIAL_CHARS索引）
+    /**
+     * @brief 所有实体，按从上到下、从左到右的顺序
+     */
+    const std::vector<Entity> &getEntities() const { return terrain->entities; }
+
+private:
     enum class LineType
     {
         WALL,        // 墙壁
@@ -208,25 +441,25 @@ private:
      * @brief 一个结构体，用于储存读取时是否已经读到了某些必要的行
      * @note 此处缩写了，因为与 LineType 前 3 个一一对应
      */
-    bool is_empty;                   // 地图读取到目前位置是否为空
-    bool modified;                   // 地图是否被修改过
-    bool is_valid;                   // 该地图类是否有效
+    bool is_empty = true;            // 地图读取到目前位置是否为空
+    bool modified = false;           // 地图是否被修改过
+    bool is_valid = false;           // 该地图类是否有效
     std::string valid_msg;           // 关于地图是否有效的消息
-    char map[MAX_HEIGHT][MAX_WIDTH]; // 地图数组
-    int max_width;                   // 地图最大宽度
-    int max_height;                  // 地图最大高度
+    Position error_pos {-1, -1};     // 加载失败时出错的位置，见 getErrorPos
+    int line_offset = 0;             // 地图第一行之前跳过的行数
+    std::shared_ptr<const Terrain> terrain; // 共享的地形，不会为空
     // 方向数组
     inline static int DIRECTIONS[4][2] = {
         {-1, 0},
         {0, 1},
         {1, 0},
         {0, -1}};
-    // Map path
-    std::string map_path;
-
     // Current position of protagonist.
-    int x;
-    int y;
+    int x = -1;
+    int y = -1;
+
+    // 是否优先加载二进制文件
+    inline static bool use_compiled = true;
 
     // 入口s、出口
 
@@ -237,53 +470,56 @@ private:
     // 性很低。
 
     // 我这里就还是用 doxygen 语法了，毕竟可读性很高
-    /**
-     * @brief 加载地图
-     * @param map_path 地图文件路径
-     */
-    Message loadMap(const std::string &filename);
+    // 全局递增的版本号，不同的 Map 对象不会得到相同的值
+    static uint64_t nextRevision();
 
     /**
-     * @brief 设置 NPC 和出口等的 ID
-     * @param rows 扫描的行数
-     * @return 返回索引建立是否成功
-     */
-    bool indexInit(const int &rows);
-
-    /**
-     * @brief 对行的类型进行辨别
-     * @return 返回一个 enum class LineType
+     * @brief 加载地图
+     * @param[out] t 加载到的地形
+     * @param filename 地图文件名
      */
-    LineType classifyLine(const std::string &line);
+    Message loadMap(Terrain &t, const std::string &filename);
 
     /**
-     * @brief 处理所有 NPC 和出入口，并进行封闭性和宽字符放置检查
-     * @return bool 地图是否封闭, 宽字符放置是否合理
+     * @brief 按路径加载地图，loadMap 检查文件名之后调用
+     * @param path 地图文件路径
      */
-    bool processMap();
+    Message loadFile(Terrain &t, const std::filesystem::path &path);
 
     /**
-     * @brief 在沿地图边界检查地图时，修改参数以进行转向
+     * @brief 从编译好的二进制文件加载地图
+     * @details 文件不存在、格式不符、已经过期或索引越界时返回错误，此时 t 保持为空
      */
-    bool calcDir(int &x, int &y, const bool &reset = false);
+    Message loadCompiled(Terrain &t, const std::string &filename);
 
     /**
-     * @brief 检查宽字符
+     * @brief 设置 NPC 和出口等的 ID，建立格子到实体的索引，并从地形中取出主角的出生点
+     * @param rows 扫描的行数
+     * @return 返回索引建立是否成功
      */
-    bool checkWideChar(const int &x, const int &y);
+    static bool indexInit(Terrain &t, const int &rows);
 
     /**
-     * @brief 获取出口 ID
+     * @brief 对行的类型进行辨别
+     * @return 返回一个 enum class LineType
      */
-    int getExitId(const Position &pos);
+    LineType classifyLine(Terrain &t, const std::string &line);
 
     /**
-     * @brief 获取NPC ID
+     * @brief 检查地图是否封闭，出入口和宽字符是否放置合理
+     * @details 1. 出入口必须是墙上宽 4 的横向缺口或高 2 的竖向缺口\n
+     *          2. 宽字符右侧的一格必须是空地\n
+     *          3. 从出生点做一次洪水填充（出入口视为墙壁），不能走到地图之外，并且每个出入口都能到达\n
+     *          只使用局部变量，时间与地图大小成线性关系，多个线程可以同时检查不同的地图
+     * @param rows 读取到的行数
+     * @param[out] where 第一个错误在文件中的行列号（从 1 开始）
+     * @return Message，不合法时 msg 中包含出错的行列号
      */
-    int getNPCId(const Position& pos);
+    Message processMap(const Terrain &t, const int &rows, Position &where) const;
 
     /**
      * @brief 储存行到地图中，并检查是否含有非法字符
+     * @return 第一个非法字符的下标，没有非法字符时返回 -1
      */
-    static bool line_copy(char map_line[], const std::string &line);
+    static int line_copy(char map_line[], const std::string &line);
 };
@@ -0,0 +1,81 @@
+/**
+ * @file MapPrefetcher.cpp
+ */
+#include "MapPrefetcher.h"
+#include <chrono>
+#include <utility>
+#include "Map.h"
+
+MapPrefetcher::MapPrefetcher(const size_t &capacity) :
+    requests(capacity), results(capacity) {
+    worker = std::thread(&MapPrefetcher::run, this);
+}
+
+MapPrefetcher::~MapPrefetcher() {
+    stopping.store(true);
+    notifyWorker();
+    if (worker.joinable()) worker.join();
+}
+
+bool MapPrefetcher::request(std::string filename) {
+    submitted.fetch_add(1, std::memory_order_acq_rel);
+    if (!requests.tryPush(std::move(filename))) {
+        submitted.fetch_sub(1, std::memory_order_acq_rel);
+        return false;
+    }
+    if (sleeping.load())
+        notifyWorker();
+    return true;
+}
+
+bool MapPrefetcher::tryTake(Loaded &loaded) {
+    return results.tryPop(loaded);
+}
+
+void MapPrefetcher::wait() {
+    uint64_t target = submitted.load(std::memory_order_acquire);
+    if (finished.load(std::memory_order_acquire) >= target) return;
+    notifyWorker();
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&] {
+        return finished.load(std::memory_order_acquire) >= target || stopping.load();
+    });
+}
+
+std::vector<std::string> MapPrefetcher::takeDropped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(dropped, {});
+}
+
+void MapPrefetcher::notifyWorker() {
+    std::lock_guard<std::mutex> lock(mutex);
+    wake_cv.notify_one();
+}
+
+void MapPrefetcher::run() {
+    std::string filename;
+    while (!stopping.load()) {
+        if (requests.tryPop(filename)) {
+            Loaded loaded {filename, std::make_shared<Map>(filename)};
+            // 主线程一直没有取走结果时丢弃这张地图，之后由主线程同步加载
+            const bool kept = results.tryPush(std::move(loaded));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!kept)
+                    dropped.push_back(filename);
+                finished.fetch_add(1, std::memory_order_acq_rel);
+            }
+            done_cv.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.store(true);
+        // 超时只是兜底，正常情况下由主线程唤醒
+        wake_cv.wait_for(lock, std::chrono::milliseconds(100), [&] {
+            return !requests.empty() || stopping.load();
+        });
+        sleeping.store(false);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    done_cv.notify_all();
+}
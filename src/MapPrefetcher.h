@@ -0,0 +1,99 @@
+/**
+ * @file MapPrefetcher.h
+ * @details 后台预加载地图，供 World 使用
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BoundedQueue.h"
+
+class Map;
+
+/**
+ * @brief 后台预加载地图
+ * @details 主线程通过有界无锁队列提交地图文件名，后台线程加载并检查地图，再通过另一个
+ *          无锁队列把 Map 交还给主线程，主线程在需要时取走\n
+ *          预加载只是尽力而为：队列满时请求或结果会被丢弃，主线程之后照常同步加载
+ * @note 交还的 Map 只由取走它的线程使用，后台线程不会再访问
+ */
+class MapPrefetcher {
+public:
+    /**
+     * @brief 一张加载好的地图
+     */
+    struct Loaded {
+        std::string filename;     ///< 地图文件名
+        std::shared_ptr<Map> map; ///< 加载的地图，可能无效
+    };
+
+    /**
+     * @brief 启动后台线程
+     * @param capacity 请求队列与结果队列的容量
+     */
+    explicit MapPrefetcher(const size_t &capacity = 16);
+
+    /**
+     * @brief 析构函数，放弃还没有开始的请求并停止后台线程
+     */
+    ~MapPrefetcher();
+
+    MapPrefetcher(const MapPrefetcher &) = delete;
+    MapPrefetcher &operator=(const MapPrefetcher &) = delete;
+
+    /**
+     * @brief 请求预加载一张地图
+     * @param filename 地图文件名，规则与 Map 的构造函数相同
+     * @return 请求队列已满时返回 false
+     */
+    bool request(std::string filename);
+
+    /**
+     * @brief 取走一张加载好的地图
+     * @return 没有加载好的地图时返回 false
+     */
+    bool tryTake(Loaded &loaded);
+
+    /**
+     * @brief 取走因结果队列已满而被丢弃的地图文件名
+     * @details 调用者据此撤销对这些地图的等待，之后需要时同步加载
+     */
+    std::vector<std::string> takeDropped();
+
+    /**
+     * @brief 等待所有已提交的请求处理完
+     */
+    void wait();
+
+    /**
+     * @brief 后台线程加载完成的地图数
+     */
+    uint64_t loadedCount() const { return finished.load(std::memory_order_acquire); }
+
+private:
+    BoundedQueue<std::string> requests;
+    BoundedQueue<Loaded> results;
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> finished{0};
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+
+    std::mutex mutex;
+    // 被丢弃的地图，由 mutex 保护
+    std::vector<std::string> dropped;
+    std::condition_variable wake_cv;
+    std::condition_variable done_cv;
+    std::thread worker;
+
+    // 后台线程主循环
+    void run();
+
+    // 唤醒后台线程
+    void notifyWorker();
+};
@@ -0,0 +1,46 @@
+/**
+ * @file MappedFile.cpp
+ */
+#include "MappedFile.h"
+#include <fstream>
+#include <iterator>
+#if defined(__linux__)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat info = {};
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            bytes = static_cast<const uint8_t*>(address);
+            length = static_cast<size_t>(info.st_size);
+        }
+    }
+    // 映射建立之后文件描述符就不再需要了
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return;
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (!buffer.empty()) {
+        bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+        length = buffer.size();
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(__linux__)
+    if (bytes)
+        munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+}
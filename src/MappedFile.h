@@ -0,0 +1,48 @@
+/**
+ * @file MappedFile.h
+ * @details 只读的内存映射文件
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/**
+ * @brief 只读的内存映射文件
+ * @details Linux 下使用 mmap 把整个文件映射到内存中，析构时解除映射；
+ *          其他平台退化为一次性读入缓冲区，接口保持一致
+ * @note 空文件和打开失败都视为无效
+ */
+class MappedFile {
+public:
+    /**
+     * @param path 文件路径
+     */
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief 文件是否成功映射
+     */
+    bool valid() const { return bytes != nullptr; }
+
+    /**
+     * @brief 文件内容的首地址
+     */
+    const uint8_t* data() const { return bytes; }
+
+    /**
+     * @brief 文件的字节数
+     */
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    // 无法映射时使用的缓冲区
+    std::string buffer;
+};
@@ -7,6 +7,7 @@
 #include "View.h"
 #include "backpack.h"
 #include "InputHandler.h"
+#include "Log.h"
 
 #include <fstream>
 #include <algorithm>
@@ -308,10 +309,10 @@ void NPC::startInteraction() {
     view->printOptions(outputs_options);
 
     int choice = -1;
-    controller->log(Controller::LogLevel::DEBUG, "node.options.size()=" + std::to_string(node.options.size()));
+    GAME_LOG(DEBUG, "node.options.size()=" + std::to_string(node.options.size()));
     if (node.options.size() == 0)
     {
-        controller->log(Controller::LogLevel::DEBUG, "Exit node");
+        GAME_LOG(DEBUG, "Exit node");
         return;
     }
 
@@ -320,6 +321,9 @@ void NPC::startInteraction() {
         while (1)
         {
             press_ascii = Controller::getInstance()->input->waitKeyDown();
+            // 输入已关闭
+            if (press_ascii == -1)
+                return;
             if (press_ascii >= '0' && (press_ascii - '0') <= node.options.size())
             {
                 break;
@@ -328,16 +332,16 @@ void NPC::startInteraction() {
         view->reDraw();
         press_ascii -= '0';
         choice = press_ascii;
-        controller->log(Controller::LogLevel::DEBUG, "用户输入：" + std::to_string(press_ascii));
+        GAME_LOG(DEBUG, "用户输入：" + std::to_string(press_ascii));
         if (press_ascii < 0 || press_ascii > 9) {
             controller->log(Controller::LogLevel::ERR, "非法选项输入");
             continue;
         }
 
         if (choice < 0)
-            controller->log(Controller::LogLevel::DEBUG, "choice < 0!");
+            GAME_LOG(DEBUG, "choice < 0!");
         if (static_cast<size_t>(choice) >= node.options.size())
-            controller->log(Controller::LogLevel::DEBUG, "static_cast<size_t>(choice) >= node.options.size()");
+            GAME_LOG(DEBUG, "static_cast<size_t>(choice) >= node.options.size()");
 
         // 检查选项范围
         if (choice >= 0 && static_cast<size_t>(choice) < node.options.size()) {
@@ -378,7 +382,7 @@ void NPC::startInteraction() {
                 controller->log(Controller::LogLevel::ERR, ss.str());
                 continue;
             }
-            controller->log(Controller::LogLevel::DEBUG, "有效选项已选择：" + std::to_string(choice));
+            GAME_LOG(DEBUG, "有效选项已选择：" + std::to_string(choice));
             break; // 有效输入，退出循环
         } else {
             view->printQuestion("", "选择超出范围，请输入有效选项编号", "white");
@@ -401,8 +405,8 @@ void NPC::handleOptionSelection(int optionIndex) {
         auto &option = interactionTree[currentInteractionId].options[optionIndex];
         currentInteractionId = option.next;
 
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG, "选项已完成！即将进入下一个节点：");
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG, "optionIndex: " + std::to_string(optionIndex) + " next: " + currentInteractionId);
+        GAME_LOG(DEBUG, "选项已完成！即将进入下一个节点：");
+        GAME_LOG(DEBUG, "optionIndex: " + std::to_string(optionIndex) + " next: " + currentInteractionId);
         startInteraction();
     }
     else
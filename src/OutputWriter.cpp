@@ -0,0 +1,59 @@
+/**
+ * @file OutputWriter.cpp
+ */
+#include "OutputWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+OutputWriter::OutputWriter(const int& fd, const size_t& capacity) : fd(fd) {
+    frame.reserve(capacity);
+}
+
+Message OutputWriter::flush() {
+    if (frame.empty())
+        return {"Empty frame", 1};
+    Message msg {"Success", 0};
+    uint64_t syscalls = 0;
+    if (stream) {
+        stream->write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        stream->flush();
+        ++syscalls;
+        if (!*stream)
+            msg = {"写入输出流失败", -1};
+    } else {
+        // 之前通过 std::cout 输出的内容必须先到达终端
+        std::cout.flush();
+        size_t written = 0;
+        while (written < frame.size()) {
+#if defined(_WIN32)
+            int n = _write(fd, frame.data() + written, static_cast<unsigned int>(frame.size() - written));
+#else
+            ssize_t n = ::write(fd, frame.data() + written, frame.size() - written);
+#endif
+            ++syscalls;
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                msg = {std::string("写入终端失败: ") + std::strerror(errno), -1};
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+    }
+    stats.frames += 1;
+    stats.bytes += frame.size();
+    stats.syscalls += syscalls;
+    stats.frame_bytes = frame.size();
+    stats.frame_syscalls = syscalls;
+    stats.max_frame_bytes = std::max<uint64_t>(stats.max_frame_bytes, frame.size());
+    // clear 保留容量，下一帧不再分配内存
+    frame.clear();
+    return msg;
+}
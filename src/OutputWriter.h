@@ -0,0 +1,66 @@
+/**
+ * @file OutputWriter.h
+ * @details 帧输出缓冲区，View 的每一帧只调用一次 write
+ */
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "tools.h"
+
+/**
+ * @brief 按帧输出到终端
+ * @details 一帧中的所有转义序列和字形先追加到一个可复用的缓冲区中，flush() 时用一次
+ *          write 系统调用写到文件描述符（默认为标准输出），只有内核没有一次写完时才会继续写剩余部分\n
+ *          flush() 之前会先刷新 std::cout，保证与其他输出的顺序一致
+ * @note 设置了输出流（setStream）时改为写入该流，用于 `game bench-replay` 捕获画面
+ */
+class OutputWriter {
+public:
+    /**
+     * @brief 输出统计
+     */
+    struct Stats {
+        uint64_t frames = 0;          ///< 输出的帧数
+        uint64_t bytes = 0;           ///< 输出的总字节数
+        uint64_t syscalls = 0;        ///< write 调用的总次数
+        uint64_t frame_bytes = 0;     ///< 最近一帧的字节数
+        uint64_t frame_syscalls = 0;  ///< 最近一帧的 write 次数
+        uint64_t max_frame_bytes = 0; ///< 最大一帧的字节数
+    };
+
+    /**
+     * @param fd 输出的文件描述符
+     * @param capacity 缓冲区的初始容量
+     */
+    explicit OutputWriter(const int& fd = 1, const size_t& capacity = 64 * 1024);
+
+    /**
+     * @brief 当前帧的缓冲区，绘制代码直接向其中追加内容
+     */
+    std::string& buffer() { return frame; }
+
+    void append(const std::string& bytes) { frame += bytes; }
+    void append(const char* bytes, const size_t& length) { frame.append(bytes, length); }
+
+    /**
+     * @brief 输出当前帧并清空缓冲区，缓冲区为空时什么也不做
+     * @return Message，写入失败时 status 为 -1
+     */
+    Message flush();
+
+    /**
+     * @brief 改为写入输出流，为空时恢复写入文件描述符
+     */
+    void setStream(std::ostream* stream) { this->stream = stream; }
+
+    const Stats& getStats() const { return stats; }
+
+    void resetStats() { stats = Stats(); }
+
+private:
+    int fd;
+    std::ostream* stream = nullptr;
+    std::string frame;
+    Stats stats;
+};
@@ -0,0 +1,51 @@
+/**
+ * @file Renderer.cpp
+ */
+#include "Renderer.h"
+#include <iostream>
+#if defined(__linux__)
+#   include <unistd.h>
+#   include <sys/ioctl.h>
+#elif defined(_WIN32)
+#   include <windows.h>
+#endif
+
+TerminalRenderer::TerminalRenderer() {
+    setCursorVisible(false);
+}
+
+TerminalRenderer::~TerminalRenderer() {
+    setCursorVisible(true);
+}
+
+void TerminalRenderer::querySize(int& width, int& height) {
+#if defined(__linux__)
+    struct winsize current_ws = {};
+    ioctl(STDIN_FILENO, TIOCGWINSZ, &current_ws);
+    width = current_ws.ws_col, height = current_ws.ws_row;
+#elif defined(_WIN32)
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
+    width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
+    height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+#endif
+}
+
+void TerminalRenderer::present(Screen& screen) {
+    screen.present(writer.buffer());
+    writer.flush();
+}
+
+void TerminalRenderer::setCursorVisible(const bool& visible) {
+#if defined(__linux__)
+    // 使用ANSI转义序列显示或隐藏光标
+    std::cout << (visible ? "\x1b[?25h" : "\x1b[?25l");
+    std::cout.flush();
+#elif defined(_WIN32)
+    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    CONSOLE_CURSOR_INFO cursorInfo;
+    GetConsoleCursorInfo(handle, &cursorInfo);
+    cursorInfo.bVisible = visible;
+    SetConsoleCursorInfo(handle, &cursorInfo);
+#endif
+}
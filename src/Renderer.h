@@ -0,0 +1,94 @@
+/**
+ * @file Renderer.h
+ * @details View 的输出后端，决定每一帧画面输出到哪里
+ */
+#pragma once
+#include <cstdint>
+#include "OutputWriter.h"
+#include "Screen.h"
+
+/**
+ * @brief 渲染后端接口
+ * @details View 负责布局、保存日志和游戏输出等逻辑内容，并把画面绘制到 Screen 中，
+ *          后端负责查询终端大小和输出每一帧\n
+ *          drawsScreen() 返回 false 的后端不需要画面，View 只维护逻辑内容，不再绘制 Screen
+ */
+class Renderer {
+public:
+    virtual ~Renderer() = default;
+
+    /**
+     * @brief 是否需要把画面绘制到 Screen 中
+     */
+    virtual bool drawsScreen() const = 0;
+
+    /**
+     * @brief 查询终端大小
+     * @param[out] width 列数
+     * @param[out] height 行数
+     */
+    virtual void querySize(int& width, int& height) = 0;
+
+    /**
+     * @brief 输出一帧
+     * @param screen 绘制完成的屏幕，drawsScreen() 为 false 时其内容没有意义
+     */
+    virtual void present(Screen& screen) = 0;
+};
+
+/**
+ * @brief 终端后端
+ * @details 只输出与上一帧不同的格子，每帧通过 OutputWriter 写一次，构造时隐藏光标，析构时恢复
+ */
+class TerminalRenderer : public Renderer {
+public:
+    TerminalRenderer();
+    ~TerminalRenderer() override;
+
+    bool drawsScreen() const override { return true; }
+    void querySize(int& width, int& height) override;
+    void present(Screen& screen) override;
+
+    /**
+     * @brief 帧输出，可以用于查看每帧的字节数和 write 次数，或者把画面重定向到输出流
+     */
+    OutputWriter& getWriter() { return writer; }
+
+    /**
+     * @brief 显示或隐藏终端光标
+     */
+    static void setCursorVisible(const bool& visible);
+
+private:
+    OutputWriter writer;
+};
+
+/**
+ * @brief 无界面后端
+ * @details 不输出任何内容，也不需要终端，只统计帧数，用于测试和测量游戏逻辑本身的开销
+ */
+class NullRenderer : public Renderer {
+public:
+    /**
+     * @param width 虚拟终端宽度
+     * @param height 虚拟终端高度
+     */
+    explicit NullRenderer(const int& width = 220, const int& height = 70) :
+        width(width), height(height) {}
+
+    bool drawsScreen() const override { return false; }
+    void querySize(int& width, int& height) override {
+        width = this->width, height = this->height;
+    }
+    void present(Screen&) override { ++frames; }
+
+    /**
+     * @brief 已经输出的帧数
+     */
+    uint64_t getFrames() const { return frames; }
+
+private:
+    int width;
+    int height;
+    uint64_t frames = 0;
+};
@@ -0,0 +1,224 @@
+/**
+ * @file ReplayInput.cpp
+ */
+#include "ReplayInput.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    // 与 InputHandler 保持一致：大写字母转换为小写
+    int normalizeKey(char ch) {
+        if (ch >= 'A' && ch <= 'Z')
+            return ch + 32;
+        return static_cast<unsigned char>(ch);
+    }
+
+    int keyByName(const std::string &name) {
+        static const std::unordered_map<std::string, int> names = {
+            {"enter", InputSource::KEY_ENTER},
+            {"esc", InputSource::KEY_ESC},
+            {"backspace", InputSource::KEY_BACKSPACE},
+            {"up", InputSource::KEY_UP},
+            {"down", InputSource::KEY_DOWN},
+            {"left", InputSource::KEY_LEFT},
+            {"right", InputSource::KEY_RIGHT},
+            {"space", ' '}
+        };
+        auto iter = names.find(name);
+        if (iter != names.end())
+            return iter->second;
+        if (name.size() == 1)
+            return normalizeKey(name[0]);
+        return -1;
+    }
+}
+
+ReplayInput::ReplayInput(std::istream &script) {
+    std::string line;
+    int line_no = 0, delay_ms = 0;
+    while (std::getline(script, line)) {
+        ++line_no;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        size_t begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos || line[begin] == '#')
+            continue;
+        size_t space = line.find(' ', begin);
+        std::string op = line.substr(begin, space == std::string::npos ? std::string::npos : space - begin);
+        std::string arg = space == std::string::npos ? "" : line.substr(space + 1);
+
+        Step step;
+        if (op == "login") {
+            if (arg.empty()) {
+                valid_msg = "第 " + std::to_string(line_no) + " 行: login 缺少用户名";
+                return;
+            }
+            logins.push_back(arg);
+            continue;
+        } else if (op == "sleep") {
+            try {
+                delay_ms += std::max(0, std::stoi(arg));
+            } catch (const std::exception &) {
+                valid_msg = "第 " + std::to_string(line_no) + " 行: 非法的等待时间 '" + arg + "'";
+                return;
+            }
+            continue;
+        } else if (op == "cmd" || op == "type") {
+            for (char ch : arg)
+                step.keys.push_back(normalizeKey(ch));
+            if (op == "cmd")
+                step.keys.push_back(KEY_ENTER);
+        } else if (op == "key") {
+            int key = keyByName(arg);
+            if (key == -1) {
+                valid_msg = "第 " + std::to_string(line_no) + " 行: 未知按键 '" + arg + "'";
+                return;
+            }
+            step.keys.push_back(key);
+        } else {
+            valid_msg = "第 " + std::to_string(line_no) + " 行: 未知指令 '" + op + "'";
+            return;
+        }
+        if (step.keys.empty()) {
+            valid_msg = "第 " + std::to_string(line_no) + " 行: " + op + " 缺少按键";
+            return;
+        }
+        step.label = op + " " + arg;
+        step.delay_ms = delay_ms;
+        delay_ms = 0;
+        steps.push_back(std::move(step));
+    }
+}
+
+bool ReplayInput::readLine(std::string &line) {
+    if (logins.empty())
+        return false;
+    line = logins.front();
+    logins.pop_front();
+    return true;
+}
+
+void ReplayInput::closeMeasurement(const Clock::time_point &now) {
+    if (open_step < 0)
+        return;
+    steps[open_step].latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - open_since).count();
+    open_step = -1;
+}
+
+int ReplayInput::readKey(const int &timeout_ms) {
+    auto now = Clock::now();
+    if (!started) {
+        started = true;
+        last_delivery = now;
+    }
+    // 不等待的读取（例如 drainKeys）不结束计时，游戏随后对整批按键的处理仍然计入当前步骤
+    if (finished()) {
+        if (timeout_ms != 0)
+            closeMeasurement(now);
+        return -1;
+    }
+
+    // 玩家看到游戏再次等待输入之后才会开始下一步，不等待的读取只能拿到当前步骤剩下的按键
+    if (key_index == 0 && timeout_ms == 0)
+        return KEY_TIMEOUT;
+
+    Step &step = steps[step_index];
+    auto due = last_delivery + std::chrono::milliseconds(key_index == 0 ? step.delay_ms : 0);
+    if (due > now) {
+        if (timeout_ms == 0)
+            return KEY_TIMEOUT;
+        closeMeasurement(now);
+        if (timeout_ms > 0 && due - now > std::chrono::milliseconds(timeout_ms)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return KEY_TIMEOUT;
+        }
+        std::this_thread::sleep_until(due);
+    } else {
+        closeMeasurement(now);
+    }
+
+    int key = step.keys[key_index];
+    open_step = static_cast<long>(step_index);
+    if (++key_index == step.keys.size()) {
+        step.done = true;
+        ++step_index;
+        key_index = 0;
+    }
+    last_delivery = open_since = Clock::now();
+    return key;
+}
+
+Message ReplayInput::report(std::ostream &out) const {
+    struct Summary {
+        std::string label;
+        size_t count = 0;
+        int64_t total_ns = 0;
+        int64_t max_ns = 0;
+    };
+    std::vector<Summary> summaries;
+    std::unordered_map<std::string, size_t> index;
+    int64_t total_ns = 0;
+    size_t done = 0;
+    for (const auto &step : steps) {
+        if (!step.done)
+            continue;
+        ++done;
+        auto iter = index.find(step.label);
+        if (iter == index.end()) {
+            iter = index.emplace(step.label, summaries.size()).first;
+            summaries.push_back({step.label});
+        }
+        Summary &summary = summaries[iter->second];
+        ++summary.count;
+        summary.total_ns += step.latency_ns;
+        summary.max_ns = std::max(summary.max_ns, step.latency_ns);
+        total_ns += step.latency_ns;
+    }
+
+    size_t width = 8;
+    for (const auto &summary : summaries)
+        width = std::max(width, summary.label.size());
+    out << std::left << std::setw(static_cast<int>(width)) << "step" << std::right
+        << std::setw(8) << "count" << std::setw(12) << "mean(ms)"
+        << std::setw(12) << "max(ms)" << std::setw(12) << "total(ms)" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (const auto &summary : summaries) {
+        out << std::left << std::setw(static_cast<int>(width)) << summary.label << std::right
+            << std::setw(8) << summary.count
+            << std::setw(12) << summary.total_ns / 1e6 / summary.count
+            << std::setw(12) << summary.max_ns / 1e6
+            << std::setw(12) << summary.total_ns / 1e6 << std::endl;
+    }
+    out << "replayed " << done << "/" << steps.size() << " steps, "
+        << total_ns / 1e6 << " ms spent in the game" << std::endl;
+    if (done != steps.size()) {
+        return {"游戏在脚本回放完之前退出", 1};
+    }
+    return {"Success", 0};
+}
+
+OutputCapture::int_type OutputCapture::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+        return traits_type::not_eof(ch);
+    ++byte_count;
+    if (target)
+        target->put(traits_type::to_char_type(ch));
+    return ch;
+}
+
+std::streamsize OutputCapture::xsputn(const char *s, std::streamsize n) {
+    byte_count += static_cast<uint64_t>(n);
+    if (target)
+        target->write(s, n);
+    return n;
+}
+
+int OutputCapture::sync() {
+    ++flush_count;
+    if (target)
+        target->flush();
+    return 0;
+}
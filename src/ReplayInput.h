@@ -0,0 +1,127 @@
+/**
+ * @file ReplayInput.h
+ * @details 脚本回放输入源和输出捕获，用于在没有终端的情况下重放一局游戏并测量延迟
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "InputSource.h"
+#include "tools.h"
+
+/**
+ * @brief 按脚本回放按键的输入源
+ * @details 脚本每行一条指令，`#` 开头的行和空行被忽略：\n
+ *          - `login <name>`  登录时输入的用户名\n
+ *          - `cmd <text>`    输入一条命令并回车，例如 `cmd move`\n
+ *          - `type <text>`   连续输入若干按键（不回车），例如移动模式下的 `type wwwdd`\n
+ *          - `key <name>`    输入一个按键：enter, esc, backspace, up, down, left, right 或单个字符\n
+ *          - `sleep <ms>`    下一条指令的按键在 ms 毫秒之后才到达\n
+ *          一条指令的按键同时到达（相当于粘贴），下一条指令的按键要等游戏再次阻塞等待输入时才到达\n
+ *          每条 cmd/type/key 指令是一个步骤，步骤的延迟为游戏处理它的每个按键所花的时间之和：
+ *          从按键交给游戏开始，到游戏再次阻塞等待按键为止\n
+ *          脚本回放完之后 waitKeyDown 返回 -1，游戏按输入关闭处理并退出
+ */
+class ReplayInput : public InputSource {
+public:
+    /**
+     * @brief 解析脚本
+     * @param script 脚本内容
+     * @note 解析失败时 valid() 返回 false，错误信息带有行号
+     */
+    explicit ReplayInput(std::istream &script);
+
+    /**
+     * @brief 脚本是否解析成功
+     */
+    bool valid() const { return valid_msg.empty(); }
+
+    /**
+     * @brief 解析失败的原因
+     */
+    const std::string &getValidMsg() const { return valid_msg; }
+
+    /**
+     * @brief 所有步骤是否都已回放
+     */
+    bool finished() const { return step_index >= steps.size(); }
+
+    /**
+     * @brief 步骤数
+     */
+    size_t stepCount() const { return steps.size(); }
+
+    bool readLine(std::string &line) override;
+
+    /**
+     * @brief 输出每类步骤的延迟统计
+     * @details 按步骤名称（例如 `cmd move`）分组，输出次数、平均值、最大值和总和
+     * @param out 输出流
+     * @return Message
+     */
+    Message report(std::ostream &out) const;
+
+protected:
+    int readKey(const int &timeout_ms) override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Step {
+        std::string label;        ///< 步骤名称，例如 "cmd move"
+        std::vector<int> keys;    ///< 按键
+        int delay_ms = 0;         ///< 第一个按键到达前的等待时间
+        int64_t latency_ns = 0;   ///< 游戏处理该步骤所花的时间
+        bool done = false;        ///< 是否已经回放完
+    };
+
+    std::vector<Step> steps;
+    std::deque<std::string> logins;
+    std::string valid_msg;
+
+    size_t step_index = 0;
+    size_t key_index = 0;
+    bool started = false;
+    Clock::time_point last_delivery;
+    // 正在计时的步骤，-1 表示没有
+    long open_step = -1;
+    Clock::time_point open_since;
+
+    void closeMeasurement(const Clock::time_point &now);
+};
+
+/**
+ * @brief 捕获输出的 streambuf
+ * @details 替换 std::cout 的缓冲区后，所有绘制都只被计数，或者转发到一个文件中
+ */
+class OutputCapture : public std::streambuf {
+public:
+    /**
+     * @param target 转发目标，为空时丢弃所有输出
+     */
+    explicit OutputCapture(std::ostream *target = nullptr) : target(target) {}
+
+    /**
+     * @brief 捕获的字节数
+     */
+    uint64_t bytes() const { return byte_count; }
+
+    /**
+     * @brief flush 的次数
+     */
+    uint64_t flushes() const { return flush_count; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    std::ostream *target;
+    uint64_t byte_count = 0;
+    uint64_t flush_count = 0;
+};
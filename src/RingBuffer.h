@@ -0,0 +1,89 @@
+/**
+ * @file RingBuffer.h
+ * @details 固定容量的环形缓冲区，满了之后新元素覆盖最旧的元素
+ */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 固定容量的环形缓冲区
+ * @details 槽位在设置容量时一次分配好，之后 pushBack 只复用已有的槽位，不再分配或释放槽位本身\n
+ *          pushBack 返回的槽位保留着被覆盖元素的内容，调用者原地修改即可复用其中的内存，
+ *          例如对 std::string 调用 assign 不会重新分配
+ * @note 下标 0 为最旧的元素，size() - 1 为最新的元素
+ */
+template <class T>
+class RingBuffer {
+public:
+    /**
+     * @param capacity 容量
+     */
+    explicit RingBuffer(const size_t& capacity = 0) : slots(capacity) {}
+
+    /**
+     * @brief 修改容量，保留最新的元素
+     * @details 会重新分配槽位，只应在容量确实改变时调用，例如窗口大小改变
+     */
+    void setCapacity(const size_t& capacity) {
+        if (capacity == slots.size())
+            return;
+        std::vector<T> resized(capacity);
+        size_t keep = std::min(count, capacity);
+        for (size_t i = 0; i < keep; ++i)
+            resized[i] = std::move((*this)[count - keep + i]);
+        slots = std::move(resized);
+        head = 0;
+        count = keep;
+    }
+
+    size_t capacity() const { return slots.size(); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == slots.size(); }
+
+    /**
+     * @brief 在末尾追加一个元素，返回它的槽位
+     * @details 缓冲区满时丢弃最旧的元素，并返回它原来的槽位
+     * @note 容量必须大于 0
+     */
+    T& pushBack() {
+        size_t index = head + count;
+        if (index >= slots.size())
+            index -= slots.size();
+        if (count == slots.size()) {
+            // 最旧的元素被覆盖
+            if (++head == slots.size())
+                head = 0;
+        } else {
+            ++count;
+        }
+        return slots[index];
+    }
+
+    /**
+     * @brief 清空所有元素，槽位及其内容留待复用
+     */
+    void clear() { head = count = 0; }
+
+    T& operator[](const size_t& index) { return slots[wrap(index)]; }
+    const T& operator[](const size_t& index) const { return slots[wrap(index)]; }
+
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[count - 1]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+private:
+    std::vector<T> slots;
+    // 最旧元素所在的槽位
+    size_t head = 0;
+    size_t count = 0;
+
+    size_t wrap(const size_t& index) const {
+        size_t slot = head + index;
+        return slot >= slots.size() ? slot - slots.size() : slot;
+    }
+};
@@ -2,6 +2,7 @@
 #include <exception>
 #include <iostream>
 #include "Controller.h"
+#include "Log.h"
 
 using json = nlohmann::json;
 
@@ -16,6 +17,11 @@ Scene::Scene(const std::string& scene_name)
     loadExits();
 }
 
+Scene::Scene(const std::string& scene_name, const json& scenes)
+    : name(scene_name) {
+    loadExits(scenes);
+}
+
 Scene::~Scene() {}
 
 bool Scene::loadSceneFile(std::filesystem::path fi) {
@@ -28,38 +34,39 @@ bool Scene::loadSceneFile(std::filesystem::path fi) {
         json scenes_json;
         file >> scenes_json;
         file.close();
-
-        // 处理场景数据
-        if (scenes_json.contains(name)) {
-            const auto& exits_obj = scenes_json[name];
-            exits.clear(); // 清空现有出口
-            
-            for (auto it = exits_obj.begin(); it != exits_obj.end(); ++it) {
-                try {
-                    int exit_id = std::stoi(it.key());
-                    std::string target_scene = it.value().get<std::string>();
-                    
-                    // 将出口信息添加到exits映射中
-                    exits[exit_id] = target_scene;
-                } catch (const std::exception& e) {
-                }
-            }
-            return true;
-        } else {
-            return false;
-        }
+        return loadExits(scenes_json);
     } catch (const std::exception& e) {
         file.close();
         return false;
     }
 }
 
+bool Scene::loadExits(const json& scenes) {
+    // 处理场景数据
+    if (!scenes.is_object() || !scenes.contains(name))
+        return false;
+    const auto& exits_obj = scenes[name];
+    exits.clear(); // 清空现有出口
+
+    for (auto it = exits_obj.begin(); it != exits_obj.end(); ++it) {
+        try {
+            int exit_id = std::stoi(it.key());
+            std::string target_scene = it.value().get<std::string>();
+
+            // 将出口信息添加到exits映射中
+            exits[exit_id] = target_scene;
+        } catch (const std::exception& e) {
+        }
+    }
+    return true;
+}
+
 void Scene::loadExits() {
     loadSceneFile(scene_file / "scenes.json");
 }
 
 std::string Scene::getSceneName(int key) {
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG , "key ok ");
+        GAME_LOG(DEBUG, "key ok ");
     auto it = exits.find(key);
     if (it != exits.end()) {
         return it->second;
@@ -69,12 +76,31 @@ std::string Scene::getSceneName(int key) {
 }
 
 std::string Scene::getNPCname(const char& specialChar) {
+    if (!npc_names_loaded && !loadNPCNames())
+        return "";
+
+    auto it = npc_names.find(specialChar);
+    if (it != npc_names.end())
+        return it->second;
+
+    // 如果没有找到匹配的NPC
+    Controller::getInstance()->log(Controller::LogLevel::WARN, "No NPC found with special char: " + std::string(1, specialChar));
+    return "";
+}
+
+bool Scene::isNPC(const char& specialChar) {
+    if (!npc_names_loaded && !loadNPCNames())
+        return false;
+    return npc_names.count(specialChar) > 0;
+}
+
+bool Scene::loadNPCNames() {
     std::filesystem::path filePath = scene_file / "NPCs.json";
     std::ifstream file(filePath);
     
     if (!file.is_open()) {
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG, "DEBUGor opening NPC file: " + filePath.string());
-        return "";
+        GAME_LOG(DEBUG, "DEBUGor opening NPC file: " + filePath.string());
+        return false;
     }
     
     // 解析 JSON
@@ -83,24 +109,21 @@ std::string Scene::getNPCname(const char& specialChar) {
         file >> npcData;
         file.close();
     } catch (const std::exception& e) {
-        Controller::getInstance()->log(Controller::LogLevel::DEBUG, "DEBUGor parsing NPC JSON: " + std::string(e.what()));
+        GAME_LOG(DEBUG, "DEBUGor parsing NPC JSON: " + std::string(e.what()));
         file.close();
-        return "";
+        return false;
     }
     
-    // 将char转换为string以便比较
-    std::string specialCharStr(1, specialChar);
-    
-    // 遍历所有 NPC 查找匹配的 special_char
+    // 记录所有 NPC 的 special_char，多个 NPC 使用同一个字符时保留第一个
+    npc_names.clear();
     for (auto& [npcName, npcInfo] : npcData.items()) {
         if (npcInfo.contains("special_char") && 
-            npcInfo["special_char"].is_string() && 
-            npcInfo["special_char"] == specialCharStr) {
-            return npcName;
+            npcInfo["special_char"].is_string()) {
+            const std::string& specialCharStr = npcInfo["special_char"].get_ref<const std::string&>();
+            if (specialCharStr.length() == 1)
+                npc_names.emplace(specialCharStr[0], npcName);
         }
     }
-    
-    // 如果没有找到匹配的NPC
-    Controller::getInstance()->log(Controller::LogLevel::WARN, "No NPC found with special char: " + specialCharStr);
-    return "";
+    npc_names_loaded = true;
+    return true;
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 #include <filesystem>
 #include "json.hpp"
@@ -31,6 +32,13 @@ public:
      * @param scene_name 场景名称
      */
     Scene(const std::string& scene_name);
+
+    /**
+     * @brief 使用已经解析好的 scenes.json 构造场景，不再读取文件
+     * @param scene_name 场景名称
+     * @param scenes scenes.json 的内容
+     */
+    Scene(const std::string& scene_name, const nlohmann::json& scenes);
     
     /**
      * @brief 析构函数
@@ -48,6 +56,13 @@ public:
      * @return 成功返回true，失败返回false
      */
     bool loadSceneFile(std::filesystem::path fi);
+
+    /**
+     * @brief 从 scenes.json 的内容中读取当前场景的出口
+     * @param scenes scenes.json 的内容
+     * @return 找到当前场景返回true，否则返回false
+     */
+    bool loadExits(const nlohmann::json& scenes);
     
     /**
      * @brief 根据出口键获取目标场景名称
@@ -57,8 +72,25 @@ public:
 
     /**
      * @brief 根据特殊字符获取NPC ID
+     * @details NPCs.json 只在第一次调用时读取，之后直接查表
      * @param specialChar NPC的特殊字符标识
      * @return NPC的ID字符串，如果未找到则返回空字符串
      */
     std::string getNPCname(const char& specialChar);
+
+    /**
+     * @brief 特殊字符是否代表一个 NPC
+     * @details 与 getNPCname 查同一张表，找不到时不输出警告
+     */
+    bool isNPC(const char& specialChar);
+
+private:
+    std::unordered_map<char, std::string> npc_names;  //< 特殊字符到 NPC ID 的映射
+    bool npc_names_loaded = false;                    //< 是否已经读取 NPCs.json
+
+    /**
+     * @brief 读取 NPCs.json 中所有 NPC 的特殊字符
+     * @return 读取或解析失败时返回 false，下次查询时会重新读取
+     */
+    bool loadNPCNames();
 };
\ No newline at end of file
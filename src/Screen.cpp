@@ -0,0 +1,277 @@
+/**
+ * @file Screen.cpp
+ */
+#include "Screen.h"
+#include "UTF8.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+    const char REPLACEMENT[] = "\xEF\xBF\xBD";
+
+    // 根据 text[index] 处的字符生成格子，返回字符占用的列数，0 表示不可见字符
+    int makeCell(const std::string& text, const size_t& index, size_t& length, const StyleId& style, Screen::Cell& cell) {
+        char32_t cp = UTF8::decode(text, index, length);
+        int w = UTF8::codepointWidth(cp);
+        if (w == 0)
+            return 0;
+        std::memset(cell.glyph, 0, sizeof(cell.glyph));
+        if (cp == 0xFFFD && length == 1) {
+            std::memcpy(cell.glyph, REPLACEMENT, 3);
+            cell.length = 3;
+        } else {
+            std::memcpy(cell.glyph, text.data() + index, length);
+            cell.length = static_cast<uint8_t>(length);
+        }
+        cell.width = static_cast<uint8_t>(w);
+        cell.style = style;
+        return w;
+    }
+
+    // 直接把整数写入输出，不构造临时字符串
+    void appendInt(std::string& out, const uint32_t& value) {
+        char digits[10];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void appendGoto(std::string& out, const int& x, const int& y) {
+        out += "\x1b[";
+        appendInt(out, static_cast<uint32_t>(x));
+        out += ';';
+        appendInt(out, static_cast<uint32_t>(y));
+        out += 'H';
+    }
+}
+
+void Screen::resize(const int& new_width, const int& new_height) {
+    if (new_width == width && new_height == height)
+        return;
+    width = std::max(0, new_width);
+    height = std::max(0, new_height);
+    back.assign(static_cast<size_t>(width) * height, Cell());
+    front = back;
+    dirty_rows.assign(height, 0);
+    scrolls.clear();
+    full_redraw = true;
+}
+
+void Screen::clear() {
+    std::fill(back.begin(), back.end(), Cell());
+    std::fill(dirty_rows.begin(), dirty_rows.end(), 1);
+}
+
+void Screen::setCell(const int& x, const int& y, const Cell& value) {
+    Cell& target = cell(x, y);
+    if (target == value)
+        return;
+    dirty_rows[x - 1] = 1;
+    // 覆盖了宽字符的后半部分，前半部分变为空格
+    if (value.width != 0 && target.width == 0 && y > 1 && cell(x, y - 1).width == 2)
+        cell(x, y - 1) = Cell();
+    // 覆盖了宽字符的前半部分，后半部分变为空格
+    if (target.width == 2 && value.width != 2 && y < width && cell(x, y + 1).width == 0)
+        cell(x, y + 1) = Cell();
+    target = value;
+}
+
+int Screen::put(const int& x, const int& y, const std::string& text, const StyleId& style, const int& limit) {
+    int col = y;
+    if (x < 1 || x > height)
+        return col;
+    int last = limit > 0 ? std::min(limit, width) : width;
+    Cell glyph, tail;
+    tail.length = 0, tail.width = 0;
+    for (size_t index = 0, length = 0; index < text.size() && col <= last; index += length) {
+        int w = makeCell(text, index, length, style, glyph);
+        if (w == 0)
+            continue;
+        if (col + w - 1 > last) {
+            // 宽字符放不下，用空格补齐
+            if (col >= 1)
+                setCell(x, col, Cell());
+            ++col;
+            break;
+        }
+        if (col >= 1) {
+            setCell(x, col, glyph);
+            if (w == 2) {
+                tail.style = style;
+                setCell(x, col + 1, tail);
+            }
+        }
+        col += w;
+    }
+    return col;
+}
+
+void Screen::fill(const int& x, const int& y, const int& count, const std::string& glyph, const StyleId& style) {
+    if (x < 1 || x > height || glyph.empty())
+        return;
+    Cell value, tail;
+    size_t length = 0;
+    int w = makeCell(glyph, 0, length, style, value);
+    if (w == 0)
+        return;
+    tail.length = 0, tail.width = 0, tail.style = style;
+    Cell* row = &back[static_cast<size_t>(x - 1) * width];
+    for (int i = 0, col = y; i < count && col + w - 1 <= width; ++i, col += w) {
+        if (col < 1)
+            continue;
+        // 大部分格子（例如空行和边框）没有变化，跳过 setCell
+        if (w == 1 && row[col - 1] == value)
+            continue;
+        setCell(x, col, value);
+        if (w == 2)
+            setCell(x, col + 1, tail);
+    }
+}
+
+void Screen::blit(const int& x, const int& y, const Screen& source, const int& source_x) {
+    if (x < 1 || x > height || source_x < 1 || source_x > source.height)
+        return;
+    const Cell* row = &source.back[static_cast<size_t>(source_x - 1) * source.width];
+    for (int i = 0, col = y; i < source.width && col <= width; ++i, ++col) {
+        // 没有变化的格子（大部分地形）跳过 setCell
+        if (col < 1 || cell(x, col) == row[i])
+            continue;
+        setCell(x, col, row[i]);
+    }
+}
+
+void Screen::shiftRect(std::vector<Cell>& buffer, const ScrollOp& op) {
+    size_t columns = static_cast<size_t>(op.right - op.left + 1);
+    for (int x = op.top; x <= op.bottom; ++x) {
+        Cell* row = &buffer[static_cast<size_t>(x - 1) * width + (op.left - 1)];
+        if (x + op.lines <= op.bottom)
+            std::copy_n(row + static_cast<size_t>(op.lines) * width, columns, row);
+        else
+            std::fill_n(row, columns, Cell());
+    }
+}
+
+void Screen::scroll(const int& top, const int& bottom, const int& left, const int& right, const int& lines) {
+    ScrollOp op {std::max(top, 1), std::min(bottom, height), std::max(left, 1), std::min(right, width), lines, hardware_scroll};
+    if (op.lines <= 0 || op.top > op.bottom || op.left > op.right)
+        return;
+    if (op.lines > op.bottom - op.top) {
+        // 滚动的行数超过区域高度，相当于清空区域
+        for (int x = op.top; x <= op.bottom; ++x)
+            fill(x, op.left, op.right - op.left + 1);
+        return;
+    }
+    shiftRect(back, op);
+    for (int x = op.top; x <= op.bottom; ++x)
+        dirty_rows[x - 1] = 1;
+    if (full_redraw)
+        return;
+    // 终端会在下一次 present() 时完成同样的滚动
+    if (hardware_scroll)
+        shiftRect(front, op);
+    scrolls.push_back(op);
+}
+
+size_t Screen::rowsDiff(const ScrollOp& op, const int& lines) const {
+    static const Cell blank;
+    size_t count = 0;
+    for (int x = op.top; x <= op.bottom; ++x) {
+        const Cell* target = &back[static_cast<size_t>(x - 1) * width];
+        const Cell* source = x + lines <= op.bottom ? &front[static_cast<size_t>(x + lines - 1) * width] : nullptr;
+        for (int y = 0; y < width; ++y)
+            count += target[y] != (source ? source[y] : blank);
+    }
+    return count;
+}
+
+void Screen::setCursor(const int& x, const int& y) {
+    cursor_x = x, cursor_y = y;
+}
+
+const Screen::Cell& Screen::at(const int& x, const int& y) const {
+    static const Cell blank;
+    if (!inside(x, y))
+        return blank;
+    return back[(x - 1) * width + (y - 1)];
+}
+
+size_t Screen::present(std::string& out) {
+    if (width == 0 || height == 0)
+        return 0;
+    if (full_redraw) {
+        // 清屏之后终端上全是空格，只需要输出非空白的格子
+        out += "\x1b[0m\x1b[2J";
+        std::fill(front.begin(), front.end(), Cell());
+        std::fill(dirty_rows.begin(), dirty_rows.end(), 1);
+        full_redraw = false;
+        placed_x = placed_y = 0;
+        scrolls.clear();
+    }
+    for (const auto& op : scrolls) {
+        if (op.hardware) {
+            // 设置左右边界，之后的上下边界和滚动只作用于区域内
+            out += "\x1b[0m\x1b[?69h\x1b[";
+            appendInt(out, static_cast<uint32_t>(op.left));
+            out += ';';
+            appendInt(out, static_cast<uint32_t>(op.right));
+            out += 's';
+        } else {
+            // 只能滚动整行，区域两侧的格子也会移动，由下面的逐格比较补画；不划算时直接重新输出区域
+            if (rowsDiff(op, op.lines) >= rowsDiff(op, 0))
+                continue;
+            shiftRect(front, {op.top, op.bottom, 1, width, op.lines, false});
+            out += "\x1b[0m";
+        }
+        // 设置上下边界，在区域内向上滚动，再恢复整个屏幕
+        out += "\x1b[";
+        appendInt(out, static_cast<uint32_t>(op.top));
+        out += ';';
+        appendInt(out, static_cast<uint32_t>(op.bottom));
+        out += "r\x1b[";
+        appendInt(out, static_cast<uint32_t>(op.lines));
+        out += "S\x1b[r";
+        if (op.hardware)
+            out += "\x1b[?69l";
+        placed_x = placed_y = 0;
+    }
+    scrolls.clear();
+
+    size_t cells = 0;
+    // 终端光标的位置和样式，-1 表示未知
+    int cx = -1, cy = -1;
+    const StyleTable& styles = StyleTable::getInstance();
+    bool style_known = false;
+    StyleId current = StyleTable::DEFAULT_STYLE;
+    for (int x = 1; x <= height; ++x) {
+        if (!dirty_rows[x - 1])
+            continue;
+        dirty_rows[x - 1] = 0;
+        for (int y = 1; y <= width; ++y) {
+            size_t index = static_cast<size_t>(x - 1) * width + (y - 1);
+            const Cell& value = back[index];
+            if (value == front[index])
+                continue;
+            front[index] = value;
+            // 宽字符的后半部分随前半部分一起输出
+            if (value.width == 0)
+                continue;
+            if (cx != x || cy != y)
+                appendGoto(out, x, y);
+            if (!style_known || value.style != current) {
+                out += styles.sgr(value.style);
+                current = value.style;
+                style_known = true;
+            }
+            out.append(value.glyph, value.length);
+            cx = x, cy = y + value.width;
+            ++cells;
+        }
+    }
+    if (style_known && current != StyleTable::DEFAULT_STYLE)
+        out += "\x1b[0m";
+    if (cells != 0 || cursor_x != placed_x || cursor_y != placed_y) {
+        appendGoto(out, cursor_x, cursor_y);
+        placed_x = cursor_x, placed_y = cursor_y;
+    }
+    return cells;
+}
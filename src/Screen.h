@@ -0,0 +1,153 @@
+/**
+ * @file Screen.h
+ * @details 终端字符格缓冲区，View 先把整帧绘制到缓冲区中，再只输出与上一帧不同的格子
+ */
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "StyleTable.h"
+
+/**
+ * @brief 双缓冲的字符格屏幕
+ * @details 屏幕被划分为 width x height 个格子，每个格子保存一个字形、它占用的列数和颜色。\n
+ *          颜色保存为 StyleTable 中的编号。绘制函数只修改后台缓冲区，
+ *          present() 将后台缓冲区与上一次输出的前台缓冲区逐格比较，
+ *          只为发生变化的格子生成光标移动、颜色和字形，最后把光标放回 setCursor 指定的位置\n
+ *          坐标与 View 保持一致：x 为行，y 为列，均从 1 开始
+ * @note 宽字符（例如中文）占用两个格子，第二个格子的 width 为 0，不单独输出
+ */
+class Screen {
+public:
+    /**
+     * @brief 一个字符格
+     */
+    struct Cell {
+        char glyph[4] = {' '};  ///< UTF-8 编码的字形，不足 4 字节的部分为 0
+        uint8_t length = 1;     ///< 字形的字节数
+        uint8_t width = 1;      ///< 占用的列数，0 表示宽字符的后半部分
+        StyleId style = StyleTable::DEFAULT_STYLE;
+
+        // 格子没有填充字节，整体比较 8 个字节
+        bool operator==(const Cell& other) const {
+            return std::memcmp(this, &other, sizeof(Cell)) == 0;
+        }
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+    static_assert(sizeof(Cell) == 8, "Screen::Cell should stay packed");
+
+    /**
+     * @brief 调整屏幕大小
+     * @details 大小发生变化时清空两个缓冲区，并在下一次 present() 时清屏重绘
+     * @param width 列数
+     * @param height 行数
+     */
+    void resize(const int& width, const int& height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    /**
+     * @brief 将后台缓冲区全部置为空格
+     */
+    void clear();
+
+    /**
+     * @brief 从 (x, y) 开始写入一段 UTF-8 文本
+     * @details 超出屏幕或超出 limit 的部分被截断，宽字符放不下时用空格补齐
+     * @param limit 允许写入的最后一列，0 表示屏幕右边界
+     * @return 写入的最后一个字形之后的列
+     */
+    int put(const int& x, const int& y, const std::string& text, const StyleId& style = StyleTable::DEFAULT_STYLE, const int& limit = 0);
+
+    /**
+     * @brief 从 (x, y) 开始重复写入 count 次同一个字形
+     * @param glyph 单个字形，例如边框字符，默认为空格
+     */
+    void fill(const int& x, const int& y, const int& count, const std::string& glyph = " ", const StyleId& style = StyleTable::DEFAULT_STYLE);
+
+    /**
+     * @brief 把另一个 Screen 的第 source_x 行整行复制到 (x, y) 开始的位置
+     * @details 用于把预先绘制好的内容（例如地形）贴到屏幕上，超出屏幕的部分被截断
+     */
+    void blit(const int& x, const int& y, const Screen& source, const int& source_x);
+
+    /**
+     * @brief 将矩形区域内的内容向上滚动 lines 行，底部空出的行填充空格
+     * @details 开启硬件滚动后，present() 先用 DECSLRM/DECSTBM 设置滚动区域，让终端完成同样的滚动，
+     *          之后只需要输出新的行\n
+     *          没有开启时，present() 比较用 DECSTBM 滚动这些行的整行和直接重新输出区域各需要输出多少格子，
+     *          整行滚动更少时让终端滚动整行，再补画区域左右两侧被一起移动的格子
+     * @param top 区域的首行
+     * @param bottom 区域的末行
+     * @param left 区域的首列
+     * @param right 区域的末列
+     * @param lines 滚动的行数
+     */
+    void scroll(const int& top, const int& bottom, const int& left, const int& right, const int& lines);
+
+    /**
+     * @brief 是否使用终端的滚动区域
+     * @note 左右边界（DECSLRM）只有 xterm 等部分终端支持，不支持的终端会滚动整行，因此默认关闭，
+     *       此时 present() 只使用所有终端都支持的整行滚动
+     */
+    void setHardwareScroll(const bool& enable) { hardware_scroll = enable; }
+
+    /**
+     * @brief 设置 present() 之后光标所在的位置
+     */
+    void setCursor(const int& x, const int& y);
+
+    /**
+     * @brief 下一次 present() 时清屏并输出所有格子
+     * @details 用于终端内容被其他输出破坏的情况，例如 refresh 命令
+     */
+    void forceFullRedraw() { full_redraw = true; }
+
+    /**
+     * @brief 输出与上一帧不同的格子
+     * @param[out] out 转义序列和字形被追加到该字符串之后
+     * @return 输出的格子数
+     */
+    size_t present(std::string& out);
+
+    /**
+     * @brief 后台缓冲区中的格子，越界时返回空格
+     */
+    const Cell& at(const int& x, const int& y) const;
+
+private:
+    int width = 0;
+    int height = 0;
+    bool full_redraw = true;
+    int cursor_x = 1;
+    int cursor_y = 1;
+    // 上一次 present() 之后光标在终端上的位置
+    int placed_x = 0;
+    int placed_y = 0;
+    std::vector<Cell> back;
+    std::vector<Cell> front;
+    // 后台缓冲区中被修改过的行，present() 只比较这些行
+    std::vector<uint8_t> dirty_rows;
+
+    // 等待输出的硬件滚动
+    struct ScrollOp {
+        int top, bottom, left, right, lines;
+        bool hardware;  ///< 使用 DECSLRM，前台缓冲区已经在 scroll() 中移动过
+    };
+    bool hardware_scroll = false;
+    std::vector<ScrollOp> scrolls;
+
+    // 将 buffer 中的矩形区域向上移动
+    void shiftRect(std::vector<Cell>& buffer, const ScrollOp& op);
+    // 前台缓冲区的 top 到 bottom 行整行上移 lines 行之后，与后台缓冲区不同的格子数
+    size_t rowsDiff(const ScrollOp& op, const int& lines) const;
+
+    bool inside(const int& x, const int& y) const {
+        return x >= 1 && x <= height && y >= 1 && y <= width;
+    }
+    Cell& cell(const int& x, const int& y) { return back[(x - 1) * width + (y - 1)]; }
+    // 写入一个格子，并修复被覆盖了一半的宽字符
+    void setCell(const int& x, const int& y, const Cell& value);
+};
@@ -4,9 +4,12 @@
 #include "InputHandler.h"
 #include "backpack.h"
 #include "View.h"
+#include "Log.h"
+#include "UTF8.h"
 #include "InputHandler.h"
 #include "backpack.h"
 #include "Protagonist.h"
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -29,7 +32,7 @@ Message Store::showProducts(int page) {
     std::stringstream ss;
     auto view = View::getInstance();
     auto controller = Controller::getInstance();
-    controller->log(Controller::LogLevel::DEBUG, std::to_string(items.size()));
+    GAME_LOG(DEBUG, std::to_string(items.size()));
 
     if (page == -1) {
         page = 0;
@@ -139,29 +142,5 @@ void Store::prompt() {
 }
 
 std::string Store::get_utf_empty(const std::string& text, const int& len) {
-    size_t length = 0, index = 0;
-    for (; index < text.length(); ) {
-        unsigned char c = static_cast<unsigned char>(text[index]);
-        if (c < 0x80) {
-            // ASCII 字符（英文字母、数字等）
-            index += 1;
-            ++length;
-        } else if ((c & 0xE0) == 0xC0) {
-            // 2字节 UTF-8 字符
-            index += 2;
-            ++length;
-        } else if ((c & 0xF0) == 0xE0) {
-            // 3字节 UTF-8 字符（包括大部分中文）
-            index += 3;
-            length += 2;
-        } else {
-            // 不支持的 UTF-8 序列
-            return "";
-        }
-    }
-    std::string res;
-    for (int i = 0; i < len - (int)length; ++ i) {
-        res += " ";
-    }
-    return res;
-}
\ No newline at end of file
+    return UTF8::padding(text, static_cast<size_t>(std::max(len, 0)));
+}
@@ -0,0 +1,70 @@
+/**
+ * @file StyleTable.cpp
+ */
+#include "StyleTable.h"
+#include <charconv>
+#include <limits>
+
+namespace {
+    void appendInt(std::string& out, const uint32_t& value) {
+        char digits[10];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void appendColor(std::string& out, const uint32_t& color, const bool& background) {
+        uint32_t value = color & 0xFFFFFF;
+        switch (color & 0xFF000000) {
+            case TextStyle::ANSI:
+                out += background ? ";4" : ";3";
+                appendInt(out, value);
+                break;
+            case TextStyle::XTERM:
+                out += background ? ";48;5;" : ";38;5;";
+                appendInt(out, value);
+                break;
+            case TextStyle::TRUE_RGB:
+                out += background ? ";48;2;" : ";38;2;";
+                appendInt(out, value >> 16 & 0xFF);
+                out += ';';
+                appendInt(out, value >> 8 & 0xFF);
+                out += ';';
+                appendInt(out, value & 0xFF);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+std::string TextStyle::sgr() const {
+    std::string out = "\x1b[0";
+    if (bold)
+        out += ";1";
+    appendColor(out, fg, false);
+    appendColor(out, bg, true);
+    out += 'm';
+    return out;
+}
+
+StyleTable& StyleTable::getInstance() {
+    static StyleTable instance;
+    return instance;
+}
+
+StyleTable::StyleTable() {
+    intern(TextStyle());
+}
+
+StyleId StyleTable::intern(const TextStyle& style) {
+    auto iter = index.find(key(style));
+    if (iter != index.end())
+        return iter->second;
+    if (styles.size() > std::numeric_limits<StyleId>::max())
+        return DEFAULT_STYLE;
+    StyleId id = static_cast<StyleId>(styles.size());
+    styles.push_back(style);
+    sequences.push_back(style.sgr());
+    index.emplace(key(style), id);
+    return id;
+}
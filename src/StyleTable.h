@@ -0,0 +1,104 @@
+/**
+ * @file StyleTable.h
+ * @details 文字样式表，把颜色和字体样式转换为紧凑的编号，并缓存对应的 SGR 序列
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tools.h"
+
+/**
+ * @brief 颜色和字体样式
+ * @details 颜色的高 8 位表示类型，低 24 位为颜色值：\n
+ *          - DEFAULT  终端默认颜色\n
+ *          - ANSI     8 色，值为 0-7，对应 SGR 30-37/40-47\n
+ *          - XTERM    256 色，对应 SGR 38;5;n/48;5;n\n
+ *          - TRUE_RGB 24 位颜色，对应 SGR 38;2;r;g;b/48;2;r;g;b
+ */
+struct TextStyle {
+    static constexpr uint32_t DEFAULT  = 0;
+    static constexpr uint32_t ANSI     = 1u << 24;
+    static constexpr uint32_t XTERM    = 2u << 24;
+    static constexpr uint32_t TRUE_RGB = 3u << 24;
+
+    uint32_t fg = DEFAULT;  ///< 前景色
+    uint32_t bg = DEFAULT;  ///< 背景色
+    bool bold = false;      ///< 是否加粗
+
+    static uint32_t ansi(const int& index) { return ANSI | static_cast<uint32_t>(index & 0x7); }
+    static uint32_t xterm(const int& index) { return XTERM | static_cast<uint32_t>(index & 0xFF); }
+    static uint32_t rgb(const Rgb& color) {
+        return TRUE_RGB | static_cast<uint32_t>((color.r & 0xFF) << 16 | (color.g & 0xFF) << 8 | (color.b & 0xFF));
+    }
+
+    bool operator==(const TextStyle& other) const {
+        return fg == other.fg && bg == other.bg && bold == other.bold;
+    }
+    bool operator!=(const TextStyle& other) const { return !(*this == other); }
+
+    /**
+     * @brief 生成设置该样式的 SGR 序列
+     * @details 序列以 0 开头，先重置再设置，因此与终端当前的样式无关
+     */
+    std::string sgr() const;
+};
+
+/**
+ * @brief 样式编号，0 为终端默认样式
+ */
+using StyleId = uint16_t;
+
+/**
+ * @brief 样式表
+ * @details 每种样式只在第一次使用时编码一次 SGR 序列，之后绘制代码只保存和比较编号，
+ *          输出时直接追加缓存的序列\n
+ *          样式表只增不减，游戏中用到的样式只有几十种
+ * @note 只应在绘制线程中使用
+ */
+class StyleTable {
+public:
+    /**
+     * @brief 终端默认样式的编号
+     */
+    static constexpr StyleId DEFAULT_STYLE = 0;
+
+    /**
+     * @brief 单例模式获取样式表
+     */
+    static StyleTable& getInstance();
+
+    /**
+     * @brief 获取样式的编号，第一次出现的样式会被加入样式表
+     * @note 样式表满时返回 DEFAULT_STYLE
+     */
+    StyleId intern(const TextStyle& style);
+
+    /**
+     * @brief 编号对应的 SGR 序列
+     */
+    const std::string& sgr(const StyleId& id) const { return sequences[id]; }
+
+    /**
+     * @brief 编号对应的样式
+     */
+    const TextStyle& get(const StyleId& id) const { return styles[id]; }
+
+    /**
+     * @brief 样式表中的样式数
+     */
+    size_t size() const { return styles.size(); }
+
+private:
+    std::vector<TextStyle> styles;
+    std::vector<std::string> sequences;
+    std::unordered_map<uint64_t, StyleId> index;
+
+    StyleTable();
+
+    static uint64_t key(const TextStyle& style) {
+        return static_cast<uint64_t>(style.fg) | static_cast<uint64_t>(style.bg) << 26 |
+               static_cast<uint64_t>(style.bold) << 52;
+    }
+};
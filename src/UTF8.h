@@ -0,0 +1,53 @@
+/**
+ * @file UTF8.h
+ * @details UTF-8 解码和终端显示宽度计算，View、Store 和 Screen 中的截断、补齐和换行都使用这里的函数
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief UTF-8 文本的显示宽度
+ * @details 宽度按照 Unicode 14 的 East Asian Width 属性计算：W/F 类（中文、全角符号、emoji）占 2 列，
+ *          组合字符和格式字符占 0 列，其余占 1 列。基本多文种平面内的码点直接查 2 位一格的宽度表，
+ *          其余码点在排好序的区间表中二分查找\n
+ *          连续的可打印 ASCII 字符每次按 8 个字节检查，不逐个解码
+ * @note Nerd Font 等私用区字形和制表符按 1 列计算，与终端的实际显示一致
+ */
+class UTF8 {
+public:
+    /**
+     * @brief 解码 text[index] 处的一个字符
+     * @param[out] length 该字符的字节数，非法序列按 1 个字节处理
+     * @return 码点，非法序列返回 U+FFFD
+     */
+    static char32_t decode(const std::string& text, const size_t& index, size_t& length);
+
+    /**
+     * @brief 单个码点在终端中占用的列数，控制字符返回 0
+     */
+    static int codepointWidth(const char32_t& cp);
+
+    /**
+     * @brief 文本的显示宽度
+     */
+    static size_t width(const std::string& text);
+
+    /**
+     * @brief 从 index 开始截取不超过 max_width 列的一段文本
+     * @details 至少前进一个字符，避免宽度为 1 的区域放不下宽字符时无法前进
+     * @param[in,out] index 起始位置，返回时指向截取部分之后的第一个字节
+     * @return 截取部分的显示宽度
+     */
+    static size_t cut(const std::string& text, size_t& index, const size_t& max_width);
+
+    /**
+     * @brief 用空格把文本补齐到 columns 列所需的空格
+     * @return 空格组成的字符串，文本已经不短于 columns 时为空
+     */
+    static std::string padding(const std::string& text, const size_t& columns);
+
+private:
+    // 从 data 开始连续的可打印 ASCII 字符数，按 8 个字节一组检查，最多检查 size 个字节
+    static size_t printableAscii(const char* data, const size_t& size);
+};
@@ -11,15 +11,17 @@
 #include "Map.h"
 #include "backpack.h"
 #include "View.h"
+#include "Log.h"
+#include "UTF8.h"
 #if defined(__linux__)
 #   include <unistd.h>
-#   include <sys/ioctl.h>
 #   include <termios.h>
     static struct termios original_termios;
 #elif defined(_WIN32)
 #   include <windows.h>
 #   include <conio.h>
 #endif
+#include <algorithm>
 #include <iostream>
 #include <string>
 
@@ -27,6 +29,13 @@ void View::clearOutputs() {
     // 清空游戏和其他输出
     logs.clear();
     game_outputs.clear();
+    puts_scrolled = logs_scrolled = 0;
+}
+
+void View::setFixedSize(const int& width, const int& height) {
+    fixed_width = width > 0 ? width : 0;
+    fixed_height = width > 0 ? height : 0;
+    resized = 1;
 }
 
 void View::disableInput() {
@@ -89,87 +98,11 @@ void View::enableInput() {
 }
 
 void View::enableCursor() {
-#if defined(__linux__)
-    std::cout << "\x1b[?25h";
-    std::cout.flush();
-#elif defined(__WIN32)
-    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_CURSOR_INFO cursorInfo;
-    GetConsoleCursorInfo(handle, &cursorInfo);
-    cursorInfo.bVisible = true; // 显示光标
-    SetConsoleCursorInfo(handle, &cursorInfo);
-#endif
+    TerminalRenderer::setCursorVisible(true);
 }
 
 void View::disableCursor() {
-#if defined(__linux__)
-    // 使用ANSI转义序列隐藏光标
-    std::cout << "\x1b[?25l";
-    std::cout.flush();
-#elif defined(__WIN32)
-    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_CURSOR_INFO cursorInfo;
-    GetConsoleCursorInfo(handle, &cursorInfo);
-    cursorInfo.bVisible = false; // 隐藏光标
-    SetConsoleCursorInfo(handle, &cursorInfo);
-#endif
-}
-
-void View::get_cursor_position(int& x, int& y) {
-#ifdef __linux__
-    struct termios oldt, newt;
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-
-    // 关闭回显和缓冲
-    newt.c_lflag &= static_cast<tcflag_t>(~(ICANON | ECHO));
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-
-    // 隐藏光标
-    std::cout << "\x1b[?25l";
-    std::cout.flush();
-#elif defined(_WIN32)
-    HANDLE hIn = GetStdHandle(STD_INPUT_HANDLE);
-    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-    DWORD mode;
-    GetConsoleMode(hIn, &mode);
-
-    // 保存原始状态
-    DWORD oldMode = mode;
-    CONSOLE_CURSOR_INFO cursorInfo;
-    GetConsoleCursorInfo(hOut, &cursorInfo);
-    bool oldVisible = cursorInfo.bVisible;
-
-    // 设置为逐字符 + 无回显
-    mode &= ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT);
-    SetConsoleMode(hIn, mode);
-
-    // 隐藏光标
-    cursorInfo.bVisible = FALSE;
-    SetConsoleCursorInfo(hOut, &cursorInfo);
-#endif
-    std::cout << "\x1b[6n" << std::flush; // 请求光标位置
-    std::string response;
-    char ch;
-    while (std::cin.get(ch)) {
-        response += ch;
-        if (ch == 'R') break;
-    }
-    int row, col;
-    if (sscanf(response.c_str(), "\x1b[%d;%dR", &row, &col) == 2) {
-        x = row, y = col;
-    } else {
-        x = -1, y = -1;
-    }
-#ifdef __linux__
-    // 恢复状态
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-#elif defined(_WIN32)
-    // 恢复状态
-    SetConsoleMode(hIn, oldMode);
-    cursorInfo.bVisible = oldVisible;
-    SetConsoleCursorInfo(hOut, &cursorInfo);
-#endif
+    TerminalRenderer::setCursorVisible(false);
 }
 
 std::shared_ptr<View> View::getInstance() {
@@ -178,35 +111,73 @@ std::shared_ptr<View> View::getInstance() {
 }
 
 View::View():
-    controller(Controller::getInstance()) {
-    disableCursor();
+    controller(Controller::getInstance()),
+    renderer(std::make_shared<TerminalRenderer>()) {
+    // 固定的样式只转换一次
+    StyleTable& styles = StyleTable::getInstance();
+    for (const auto& [name, code] : simple_colors) {
+        // simple_colors 中的值为 30-39，39 为默认颜色
+        TextStyle style;
+        int value = std::stoi(code);
+        style.fg = value == 39 ? TextStyle::DEFAULT : TextStyle::ansi(value - 30);
+        style.bold = true;
+        simple_styles.emplace(name, styles.intern(style));
+    }
+    TextStyle style;
+    style.fg = TextStyle::xterm(214);
+    style.bold = true;
+    prompt_style = styles.intern(style);
+    style = TextStyle();
+    style.fg = TextStyle::xterm(87);
+    protagonist_style = styles.intern(style);
+    style = TextStyle();
+    style.bg = TextStyle::rgb(Rgb(126, 192, 12));
+    in_style = styles.intern(style);
+    style.bg = TextStyle::rgb(Rgb(51, 102, 255));
+    out_style = styles.intern(style);
+#if defined(__linux__)
+    std::signal(SIGWINCH, &View::onResize);
+#endif
 }
 
-View::~View() {
-    enableCursor();
+View::~View() = default;
+
+void View::setRenderer(const std::shared_ptr<Renderer>& renderer) {
+    if (renderer == nullptr)
+        return;
+    this->renderer = renderer;
+    // 之前的后端可能没有绘制 Screen，也可能输出到了别处
+    screen.forceFullRedraw();
+    resized = 1;
 }
 
-bool View::reDraw() {
-    // 获取屏幕高度和宽度
-#if defined(__linux__)
-    struct winsize current_ws;
-    ioctl(STDIN_FILENO, TIOCGWINSZ, &current_ws);
-    int width = current_ws.ws_col, height = current_ws.ws_row;
-#elif defined(_WIN32)
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
-    int width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
-    int height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+void View::onResize(int) {
+    resized = 1;
+}
+
+void View::querySize() {
+    if (fixed_width > 0) {
+        term_width = fixed_width, term_height = fixed_height;
+        return;
+    }
+    renderer->querySize(term_width, term_height);
+}
+
+bool View::updateLayout() {
+#if !defined(__linux__)
+    // 没有 SIGWINCH，每次重绘时查询
+    resized = 1;
 #endif
-    // 检测地图指针是否悬空
-    if (controller->map == nullptr) {
-        controller->log(Controller::LogLevel::ERR, "悬空 Map");
-        return false;
-    } else if (!controller->map->valid()) {
-        controller->log(Controller::LogLevel::ERR, controller->map->getValidMsg());
-        controller->gameExit();
-        return false;
+    if (resized) {
+        // 先清除标记，查询期间再次收到的信号留到下一帧处理
+        resized = 0;
+        querySize();
     }
+    int width = term_width, height = term_height;
+    uint64_t revision = controller->map->getRevision();
+    if (width == layout_width && height == layout_height && revision == layout_revision)
+        return layout_fits;
+    layout_width = width, layout_height = height, layout_revision = revision;
 
     // 设置最小宽度和高度
     min_win_width = controller->map->getMaxWidth() +
@@ -222,7 +193,8 @@ bool View::reDraw() {
                    TOP_PADDING +
                    BOTTOM_PADDING;
 
-    if (width < min_win_width || height < min_win_height) {
+    layout_fits = width >= min_win_width && height >= min_win_height;
+    if (!layout_fits) {
         return false;
     }
 
@@ -237,80 +209,121 @@ bool View::reDraw() {
     puts_width = width - logs_width - 3 - LEFT_MARGIN - RIGHT_MARGIN;
     // 留出命令输入的位置
     puts_height = height - 3 - TOP_MARGIN - BOTTOM_MARGIN - 1;
-    // 清屏
-    std::cout << REASE_S << MOVHOME << std::flush;
-    // 首先绘制所有框架
-    // 为了避免 Windows 和 Linux 的行为差别，统一多加一个 \r
+    // 输出只保留能显示的行，槽位只在区域大小改变时重新分配
+    logs.setCapacity(static_cast<size_t>(logs_height));
+    game_outputs.setCapacity(static_cast<size_t>(puts_height));
+    return true;
+}
+
+bool View::reDraw(const bool& force) {
+    // 检测地图指针是否悬空
+    if (controller->map == nullptr) {
+        controller->log(Controller::LogLevel::ERR, "悬空 Map");
+        return false;
+    } else if (!controller->map->valid()) {
+        controller->log(Controller::LogLevel::ERR, controller->map->getValidMsg());
+        controller->gameExit();
+        return false;
+    }
+    // 布局只在窗口大小或地图变化时重新计算
+    if (!updateLayout()) {
+        return false;
+    }
+    protagonist_pos = controller->map->getPos();
+    panes_dirty = false;
+    frame_pending = true;
+    // 无界面时只需要布局和输出内容
+    if (!renderer->drawsScreen()) {
+        puts_scrolled = logs_scrolled = 0;
+        return true;
+    }
+    int width = layout_width, height = layout_height;
+    int map_height = controller->map->getMaxHeight();
+
+    // 窗口大小改变时 Screen 会自动清屏重绘
+    screen.resize(width, height);
+    if (force)
+        screen.forceFullRedraw();
+    screen.clear();
+    puts_drawn = logs_drawn = 0;
+    puts_scrolled = logs_scrolled = 0;
+
+    int left = LEFT_MARGIN + 1, middle = middleColumn(), right = middle + puts_width + 1;
+    int top = TOP_MARGIN + 1, bottom = height - BOTTOM_MARGIN;
     // 顶部
-    std::cout << gotoXY(TOP_MARGIN + 1, LEFT_MARGIN + 1);
-    std::cout << BLT;
-    for (int i = 0; i < map_width + LEFT_PADDING + RIGHT_PADDING; ++i)
-        std::cout << BH;
-    std::cout << BMT;
-    for (int i = 0; i < puts_width; ++i)
-        std::cout << BH;
-    std::cout << BRT << "\r" << std::endl;
+    screen.put(top, left, BLT);
+    screen.fill(top, left + 1, logs_width, BH);
+    screen.put(top, middle, BMT);
+    screen.fill(top, middle + 1, puts_width, BH);
+    screen.put(top, right, BRT);
     // 中部
-    for (int i = 0; i < height - 2 - TOP_MARGIN - BOTTOM_MARGIN; ++i) {
-        std::cout << rCols(LEFT_MARGIN) << BV;
-        std::cout << rCols(logs_width);
-        std::cout << BV;
-        std::cout << rCols(puts_width);
-        std::cout << BV << "\r" << std::endl;
-    }
-    // 中部的分割线
-    std::cout << SAVECUS;
-    // 地图高度+边框+顶部空白
-    std::cout << gotoXY(map_height + 1 + TOP_MARGIN + TOP_PADDING + BOTTOM_PADDING + 1, LEFT_MARGIN + 1);
-    std::cout << BLM;
-    for (int i = 0; i < logs_width; ++i) {
-        std::cout << BH;
-    }
-    std::cout << BMM;
-    std::cout << LOADCUS;
+    for (int x = top + 1; x < bottom; ++x) {
+        screen.put(x, left, BV);
+        screen.put(x, middle, BV);
+        screen.put(x, right, BV);
+    }
+    // 地图和日志之间的分割线：地图高度+边框+顶部空白
+    int separator = map_height + 1 + TOP_MARGIN + TOP_PADDING + BOTTOM_PADDING + 1;
+    screen.put(separator, left, BLM);
+    screen.fill(separator, left + 1, logs_width, BH);
+    screen.put(separator, middle, BMM);
     // 底部
-    std::cout << rCols(LEFT_MARGIN) << BLB;
-    for (int i = 0; i < logs_width; ++i)
-        std::cout << BH;
-    std::cout << BMB;
-    for (int i = 0; i < puts_width; ++i)
-        std::cout << BH;
-    std::cout << BRB;
-
-    // 打印地图
-    std::cout << SAVECUS;
-    std::cout << gotoXY(TOP_MARGIN + 2, LEFT_MARGIN + 1 + LEFT_PADDING + 1);
+    screen.put(bottom, left, BLB);
+    screen.fill(bottom, left + 1, logs_width, BH);
+    screen.put(bottom, middle, BMB);
+    screen.fill(bottom, middle + 1, puts_width, BH);
+    screen.put(bottom, right, BRB);
+
+    // 地形只在地图变化时重新绘制，之后每次整行复制，再画上主角
+    if (terrain_revision != controller->map->getRevision())
+        buildTerrain();
+    for (int i = 0; i < map_height; ++i) {
+        Position row = mapToScreen({i, 0});
+        screen.blit(row.x, row.y, terrain, i + 1);
+    }
+    const auto& protago = Map::SPECIAL_CHARS[Map::PROTAGONIST_INDEX];
+    Position protago_pos = mapToScreen(controller->map->getPos());
+    screen.put(protago_pos.x, protago_pos.y, protago.special_char, makeStyle(protago.simple_color, protago.rgb_color));
+
+    // 命令输入框
+    screen.put(cmdLine() - 1, middle, BLM);
+    screen.fill(cmdLine() - 1, middle + 1, puts_width, BH);
+    screen.put(cmdLine() - 1, right, BMM);
+    screen.put(cmdLine(), middle, "$", prompt_style);
+
+    drawPanes();
+    // 光标停在命令输入框下方
+    screen.setCursor(bottom, middle + 1);
+    return true;
+}
+
+void View::buildTerrain() {
+    int map_width = controller->map->getMaxWidth();
+    int map_height = controller->map->getMaxHeight();
+    terrain.resize(map_width, map_height);
+    terrain.clear();
+    // 地形的坐标从 1 开始，地形中不包含主角
+    StyleId style;
     for (int i = 0, tx, ty; i < map_height; ++i) {
         for (int j = 0; j < map_width; ++j) {
-            std::cout << charToSpecial(i, j, tx, ty);
+            std::string glyph = charToSpecial(i, j, tx, ty, style);
+            terrain.put(i + 1, j + 1, glyph, style);
             i = tx, j = ty;
         }
-        std::cout << "\r" << std::endl << rCols(LEFT_MARGIN + 1 + LEFT_PADDING);
     }
     while(!in_positions.empty()) {
         auto& pos = in_positions.front();
-        std::cout << gotoXY(pos.x, pos.y) << "\x1b[48;2;126;192;12m \x1b[0m";
-        std::cout << gotoXY(pos.x + 1, pos.y) << "\x1b[48;2;126;192;12m \x1b[0m";
+        terrain.put(pos.x + 1, pos.y + 1, " ", in_style);
+        terrain.put(pos.x + 2, pos.y + 1, " ", in_style);
         in_positions.pop();
     }
     while(!out_positions.empty()) {
         auto& pos = out_positions.front();
-        std::cout << gotoXY(pos.x, pos.y) << "\x1b[48;2;51;102;255m \x1b[0m";
-        std::cout << gotoXY(pos.x + 1, pos.y) << "\x1b[48;2;51;102;255m \x1b[0m";
+        terrain.put(pos.x + 1, pos.y + 1, " ", out_style);
+        terrain.put(pos.x + 2, pos.y + 1, " ", out_style);
         out_positions.pop();
     }
-    std::cout << LOADCUS;
-    for (int i = 0; i < puts_width + 1; ++i)
-        std::cout << "\b";
-    std::cout << SAVECUS;
-    std::cout << MOVU;
-    std::cout << "\b\x1b[38;5;214m\x1b[1m$\x1b[0m";
-    std::cout << MOVU << "\b" << BLM;
-    for (int i = 0; i < puts_width; ++i)
-        std::cout << BH;
-    std::cout << BMM;
-    std::cout << LOADCUS;
-    return true;
+    terrain_revision = controller->map->getRevision();
 }
 
 Message View::drawPoMove(const Position& last_pos, const Position& pos) {
@@ -320,19 +333,15 @@ Message View::drawPoMove(const Position& last_pos, const Position& pos) {
     if (!Position::ifInMap(last_pos, *(controller->map)) || !Position::ifInMap(pos, *(controller->map))) {
         return {"不合法的位置", -1};
     }
-    std::cout << SAVECUS;
-    gotoMap(last_pos);
-    const auto& protago = controller->map->SPECIAL_CHARS[Map::PROTAGONIST_INDEX];
-    for (int i = 0;i < protago.width; ++i) {
-        std::cout << " ";
-    }
-    std::cout << std::flush;
-    gotoMap(pos);
-    std::cout << "\x1b[38;5;87m";
-    std::cout << protago.special_char;
-    std::cout << "\x1b[0m";
-    std::cout << std::flush;
-    std::cout << LOADCUS;
+    protagonist_pos = pos;
+    if (renderer->drawsScreen()) {
+        const auto& protago = controller->map->SPECIAL_CHARS[Map::PROTAGONIST_INDEX];
+        Position last_screen = mapToScreen(last_pos), screen_pos = mapToScreen(pos);
+        screen.fill(last_screen.x, last_screen.y, protago.width);
+        screen.put(screen_pos.x, screen_pos.y, protago.special_char, protagonist_style);
+    }
+    // 擦除和绘制合并成一次输出
+    frame_pending = true;
     return {"Success", 0};
 }
 
@@ -340,7 +349,7 @@ Message View::printLog(const std::string& msg, const std::string& simple_color,
     if (logs_width <= 0) {
         return {"窗口过小", 1};
     }
-    colorPrint(msg, simple_color, rgb_color, logs, logs_width);
+    colorPrint(msg, simple_color, rgb_color, logs, logs_width, logs_scrolled);
     return {"Success", 0};
 }
 
@@ -353,7 +362,7 @@ Message View::printQuestion(const std::string &person, const std::string &msg, c
     if (person.length()) {
         text = person + ": " + msg;
     }
-    colorPrint(text, simple_color, rgb_color, game_outputs, puts_width);
+    colorPrint(text, simple_color, rgb_color, game_outputs, puts_width, puts_scrolled);
     return {"Success", 0};
 }
 
@@ -363,19 +372,22 @@ Message View::printOptions(const std::vector<std::string>& options) {
     }
     for (auto& msg : options) {
         std::string text = msg;
-        colorPrint(msg, "white", Rgb(255, 255, 255), game_outputs, puts_width);
+        colorPrint(msg, "white", Rgb(255, 255, 255), game_outputs, puts_width, puts_scrolled);
     }
     return {"Success", 0};
 }
 
 Message View::printCmd(const std::string& cmd) {
-    std::cout << SAVECUS << MOVU;
-    std::cout << "\x1b[38;5;214m\x1b[1m " << cmd << "\x1b[0m";
-    for (size_t i = 0; i < static_cast<size_t>(puts_width) - cmd.length() - 1; ++i)
-        std::cout << " ";
-    std::cout  << LOADCUS;
-    // 刷新缓冲区
-    std::cout << std::flush;
+    if (puts_width <= 0) {
+        return {"窗口过小", 1};
+    }
+    if (renderer->drawsScreen()) {
+        int col = middleColumn() + 1;
+        // 超出输入框的部分被截断
+        screen.fill(cmdLine(), col, puts_width);
+        screen.put(cmdLine(), col, " " + cmd, prompt_style, col + puts_width - 1);
+    }
+    frame_pending = true;
     return {"Success", 0};
 }
 
@@ -383,128 +395,101 @@ void View::colorPrint(
     const std::string &text,
     const std::string &simple_color,
     const  Rgb & rgb_color,
-    std::deque<std::string> &outputs,
-    const int &width) {
-    // 添加颜色
+    RingBuffer<PaneLine> &outputs,
+    const int &width,
+    int &scrolled) {
+    if (outputs.capacity() == 0)
+        return;
+    StyleId style = makeStyle(simple_color, rgb_color);
     size_t index = 0, old_index = 0;
     while (index < text.length()) {
-        std::stringstream ss;
-        if (simple_color == "") {
-            ss << "\x1b[" << "38;2;" <<  rgb_color.r << ";" <<  rgb_color.g << ";" <<  rgb_color.b << "m";
-        } else {
-            ss << "\x1b[1;" << simple_colors.at(simple_color) << "m";
-        }
-        // 插入文本
-        size_t insert_len = cutUTFString(text, index, width);
-        if (insert_len > static_cast<size_t>(width)) {
-            controller->log(Controller::LogLevel::ERR, "消息打印错误");
-            return;
-        }
-        ss << text.substr(old_index, index - old_index);
-        size_t len = index - old_index;
-        while(len < static_cast<size_t>(width)) {
-            len++;
-            ss << " ";
-        };
+        // 每行最多 width - 1 列，最后一列留空
+        UTF8::cut(text, index, static_cast<size_t>(width) - 1);
+        // 放满之后覆盖最旧的行，复用该行字符串的内存
+        if (outputs.full())
+            ++scrolled;
+        PaneLine& line = outputs.pushBack();
+        line.text.assign(text, old_index, index - old_index);
+        line.style = style;
         old_index = index;
-        // 转换为默认格式
-        ss << "\x1b[0m";
-        outputs.push_back(ss.str());
     }
     invalidate();
 }
 
+StyleId View::makeStyle(const std::string& simple_color, const Rgb& rgb_color) const {
+    if (simple_color == "") {
+        TextStyle style;
+        style.fg = TextStyle::rgb(rgb_color);
+        return StyleTable::getInstance().intern(style);
+    }
+    auto iter = simple_styles.find(simple_color);
+    return iter == simple_styles.end() ? StyleTable::DEFAULT_STYLE : iter->second;
+}
+
 void View::invalidate() {
-    // 处理游戏输出
-    while(game_outputs.size() > static_cast<size_t>(puts_height)) {
-        game_outputs.pop_front();
-    }
-    std::cout << SAVECUS;
-    // 移动到全部游戏输出的首行
-    int next_x = TOP_MARGIN + 2, next_y = LEFT_MARGIN + 1 + logs_width + 2;
-    // 输出所有游戏输出
-    for (auto iter = game_outputs.begin(); iter != game_outputs.end(); ++iter) {
-        std::cout << gotoXY(next_x, next_y);
-        std::cout << *iter;
-        next_x += 1;
-    }
-    std::cout << LOADCUS;
-
-    // 处理日志输出
-    while(logs.size() > static_cast<size_t>(logs_height)) {
-        logs.pop_front();
-    }
-    std::cout << SAVECUS;
+    // 同一帧中的多次输出只排版一次
+    panes_dirty = frame_pending = true;
+}
+
+void View::drawPanes() {
+    if (!renderer->drawsScreen()) {
+        puts_scrolled = logs_scrolled = 0;
+        return;
+    }
+    // 游戏输出从首行开始，空行用空格填满
+    int next_x = TOP_MARGIN + 2, next_y = middleColumn() + 1;
+    // 已经显示的行先整体上移，之后重绘时只有新的行发生变化
+    if (puts_scrolled > 0) {
+        screen.scroll(next_x, next_x + puts_height - 1, next_y, next_y + puts_width - 1, puts_scrolled);
+        puts_scrolled = 0;
+    }
+    // 没有内容的行只在之前有内容时才需要擦除
+    int rows = std::max(static_cast<int>(game_outputs.size()), puts_drawn);
+    for (int i = 0; i < rows && i < puts_height; ++i, ++next_x) {
+        int end = next_y;
+        if (static_cast<size_t>(i) < game_outputs.size())
+            end = screen.put(next_x, next_y, game_outputs[i].text, game_outputs[i].style, next_y + puts_width - 1);
+        screen.fill(next_x, end, next_y + puts_width - end);
+    }
+    puts_drawn = static_cast<int>(game_outputs.size());
+
     // 移动到日志输出的首行
     next_x = TOP_MARGIN + 1 + TOP_PADDING + controller->map->getMaxHeight() + BOTTOM_PADDING + 2;
     next_y = LEFT_MARGIN + 2;
-    for (auto iter = logs.begin(); iter != logs.end(); ++iter) {
-        std::cout << gotoXY(next_x, next_y);
-        std::cout << *iter;
-        next_x += 1;
-    }
-    std::cout << LOADCUS;
-    // 刷新缓冲区
-    std::cout << std::flush;
-}
-
-std::string View::uLines(const int &lines) const {
-    std::stringstream ss;
-    ss << "\x1b[" << lines << "A";
-    return ss.str();
-}
-std::string View::dLines(const int& lines) const {
-    std::stringstream ss;
-    ss << "\x1b[" << lines << "B";
-    return ss.str();
-}
-std::string View::rCols(const int& cols) const {
-    std::stringstream ss;
-    ss << "\x1b[" << cols << "C";
-    return ss.str();
-}
-std::string View::lCols(const int& cols) const {
-    std::stringstream ss;
-    ss << "\x1b[" << cols << "D";
-    return ss.str();
+    if (logs_scrolled > 0) {
+        screen.scroll(next_x, next_x + logs_height - 1, next_y, next_y + logs_width - 1, logs_scrolled);
+        logs_scrolled = 0;
+    }
+    rows = std::max(static_cast<int>(logs.size()), logs_drawn);
+    for (int i = 0; i < rows && i < logs_height; ++i, ++next_x) {
+        int end = next_y;
+        if (static_cast<size_t>(i) < logs.size())
+            end = screen.put(next_x, next_y, logs[i].text, logs[i].style, next_y + logs_width - 1);
+        screen.fill(next_x, end, next_y + logs_width - end);
+    }
+    logs_drawn = static_cast<int>(logs.size());
 }
 
-std::string View::gotoXY(const int& x, const int& y) const {
-    std::stringstream ss;
-    ss << "\x1b[" << x << ";" << y << "f";
-    return ss.str();
+void View::present() {
+    // 窗口大小在两帧之间发生了变化，这一帧改为按新的布局整体重绘
+    if (resized && controller->map != nullptr && controller->map->valid() && !reDraw())
+        return;
+    if (!frame_pending)
+        return;
+    if (panes_dirty)
+        drawPanes();
+    panes_dirty = frame_pending = false;
+    flush();
 }
 
-size_t View::cutUTFString(const std::string& utf8_str, size_t& index, const int& width) {
-    // 该函数适用于绝大多数常用字符，但对一些偏僻字符可能会出错
-    size_t length = 0;
-    for (; index < utf8_str.length() && length < static_cast<size_t>(width) - 1; ) {
-        unsigned char c = static_cast<unsigned char>(utf8_str[index]);
-        if (c < 0x80) {
-            // ASCII 字符（英文字母、数字等）
-            index += 1;
-            ++length;
-        } else if ((c & 0xE0) == 0xC0) {
-            // 2字节 UTF-8 字符
-            index += 2;
-            ++length;
-        } else if ((c & 0xF0) == 0xE0) {
-            // 3字节 UTF-8 字符（包括大部分中文）
-            // 字节3 UTF
-            index += 3;
-            length += 2;
-        } else {
-            // 不支持的 UTF-8 序列
-            return 0xFFFF;
-        }
-    }
-
-    return length;
+void View::flush() {
+    renderer->present(screen);
 }
 
-std::string View::charToSpecial(const int &x, const int &y, int &tx, int &ty) {
-    char (*map)[Map::MAX_WIDTH] = controller->map->map;
+std::string View::charToSpecial(const int &x, const int &y, int &tx, int &ty, StyleId& style) {
+    const char (*map)[Map::MAX_WIDTH] = controller->map->terrain->map;
     tx = x, ty = y;
+    style = StyleTable::DEFAULT_STYLE;
     int wall_type = 0;
     if (map[x][y] == '#') {
         int bit_1 = 1;
@@ -555,24 +540,22 @@ std::string View::charToSpecial(const int &x, const int &y, int &tx, int &ty) {
     if (map[x][y] == 'o') {
         if (y >= 1 && y + 4 < Map::MAX_WIDTH && map[x][y-1] == '#' && map[x][y + 4] == '#') {
             ty = y + 3;
-            return "\x1b[48;2;51;102;255m    \x1b[0m";
+            style = out_style;
+            return "    ";
         }
         if (x >= 1 && x + 2 < Map::MAX_HEIGHT && map[x-1][y] == '#' && map[x + 2][y] == '#') {
-            int oldx, oldy;
-            get_cursor_position(oldx, oldy);
-            out_positions.push({oldx, oldy});
+            out_positions.push({x, y});
             return " ";
         }
     } else if (map[x][y] == 'i') {
         if (y >= 1 && y + 4 < Map::MAX_WIDTH && map[x][y-1] == '#' && map[x][y + 4] == '#') {
             ty = y + 3;
-            return "\x1b[48;2;126;192;12m    \x1b[0m";
+            style = in_style;
+            return "    ";
         }
         
         if (x >= 1 && x + 2 < Map::MAX_HEIGHT && map[x-1][y] == '#' && map[x + 2][y] == '#') {
-            int oldx, oldy;
-            get_cursor_position(oldx, oldy);
-            in_positions.push({oldx, oldy});
+            in_positions.push({x, y});
             return " ";
         }
     }
@@ -582,29 +565,15 @@ std::string View::charToSpecial(const int &x, const int &y, int &tx, int &ty) {
         if (!Map::SPECIAL_CHARS[index].need_empty) {
             ty += Map::SPECIAL_CHARS[index].width - 1;
         }
-        auto rgb_color = Map::SPECIAL_CHARS[index].rgb_color;
-        auto simple_color = Map::SPECIAL_CHARS[index].simple_color;
-        std::stringstream ss;
-        if (simple_color == "") {
-            ss << "\x1b[" << "38;2;" <<  rgb_color.r << ";" <<  rgb_color.g << ";" <<  rgb_color.b << "m";
-        } else {
-            ss << "\x1b[1;" << simple_colors.at(simple_color) << "m";
-        }
-        ss << Map::SPECIAL_CHARS[index].special_char;
-        ss << "\x1b[0m";
-        return ss.str();
+        style = makeStyle(Map::SPECIAL_CHARS[index].simple_color, Map::SPECIAL_CHARS[index].rgb_color);
+        return Map::SPECIAL_CHARS[index].special_char;
     }
 
     return " ";
 }
 
-bool View::gotoMap(const Position& pos) {
-    if (!Position::ifInMap(pos, *(controller->map))) {
-        controller->log(Controller::LogLevel::DEBUG, "Not in Map");
-        return false;
-    }
+Position View::mapToScreen(const Position& pos) const {
     int bx = TOP_MARGIN + 1 + TOP_PADDING + 1;
     int by = LEFT_MARGIN + 1 + LEFT_PADDING + 1;
-    std::cout << gotoXY(pos.x + bx, pos.y + by);
-    return true;
+    return {pos.x + bx, pos.y + by};
 }
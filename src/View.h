@@ -5,24 +5,22 @@
  * @author Jie Jiang
  */
 #pragma once
+#include <csignal>
 #include <vector>
-#include <deque>
 #include <queue>
 #include <memory>
 #include <unordered_map>
 #include "json.hpp"
 #include "tools.h"
 #include "Controller.h"
+#include "Screen.h"
+#include "Renderer.h"
+#include "RingBuffer.h"
 class Controller;
-/**
- * @brief 光标移动到指定坐标
- * @param line 指定行
- * @param col 指定列
- * @return a ANSI Escape string
- */
-
 /**
  * @brief 渲染类
+ * @details 所有绘制先写入 Screen 的后台缓冲区，present() 时交给 Renderer 输出，
+ *          默认的终端后端只输出与上一帧不同的格子
  * @note 该类的重要原则应当时刻保证绘制完成之后光标处于控制页面输入处
  */
 class View {
@@ -41,7 +39,7 @@ public:
     };
     /**
      * @brief 析构函数
-     * @details 将会恢复光标
+     * @details 终端后端随之析构时会恢复光标
      */
     ~View();
     /**
@@ -51,10 +49,12 @@ public:
     static std::shared_ptr<View> getInstance();
     /**
      * @brief 全局重绘
-     * @note 丢失所有已经绘制的图形，仅保留地图，建议在窗口大小发生改变时应用此函数
+     * @details 重新计算布局并绘制边框、地图、日志和游戏输出，在下一次 present() 时输出
+     * @note 命令输入行会被清空，建议在窗口大小发生改变时应用此函数
+     * @param force 是否清屏并输出所有格子，用于终端内容被破坏的情况
      * @return bool
      */
-    bool reDraw();
+    bool reDraw(const bool& force = false);
 
     /**
      * @brief 局部重绘
@@ -114,6 +114,15 @@ public:
      * @return Message
      */
     Message printCmd(const std::string& cmd);
+
+    /**
+     * @brief 输出积攒的画面
+     * @details 绘制函数只修改 Screen 并标记需要输出，日志和游戏输出也只在这里重新排版一次，
+     *          一个事件中的多次输出因此只产生一帧\n
+     *          Controller 在每个事件处理完之后，以及等待输入之前调用该函数；
+     *          两帧之间窗口大小发生了变化时改为整体重绘
+     */
+    void present();
     
     /**
      * @brief 清空屏幕
@@ -145,6 +154,57 @@ public:
      */
     void clearOutputs();
 
+    /**
+     * @brief 使用固定的窗口大小，不再查询终端
+     * @details 用于没有终端的场景，例如 `game bench-replay`
+     * @param width 宽度，小于等于 0 时恢复查询终端
+     * @param height 高度
+     */
+    void setFixedSize(const int& width, const int& height);
+
+    /**
+     * @brief 更换渲染后端
+     * @details 下一帧按新后端的窗口大小重新布局，并完整重绘
+     * @param renderer 新的后端，为空时不做任何事
+     */
+    void setRenderer(const std::shared_ptr<Renderer>& renderer);
+
+    /**
+     * @brief 当前的渲染后端
+     */
+    std::shared_ptr<Renderer> getRenderer() const { return renderer; }
+
+    /**
+     * @brief 是否使用终端的滚动区域滚动日志和游戏输出
+     * @details 开启后，输出满了之后新增一行只需要输出一行；否则只能滚动整行，
+     *          与窗格在同一行的地图或另一个窗格需要补画，比重新输出整个区域更贵时不滚动
+     * @note 需要终端支持 DECSLRM（例如 xterm），默认关闭
+     */
+    void setScrollRegions(const bool& enable) { screen.setHardwareScroll(enable); }
+
+    /**
+     * @brief 日志和游戏输出中的一行，颜色保存为样式编号
+     */
+    struct PaneLine {
+        std::string text;
+        StyleId style = StyleTable::DEFAULT_STYLE;
+    };
+
+    /**
+     * @brief 当前显示的日志，每个元素为一行
+     */
+    const RingBuffer<PaneLine>& getLogs() const { return logs; }
+
+    /**
+     * @brief 当前显示的游戏输出，每个元素为一行
+     */
+    const RingBuffer<PaneLine>& getGameOutputs() const { return game_outputs; }
+
+    /**
+     * @brief 最近一次绘制主角时使用的地图坐标
+     */
+    Position getProtagonistPos() const { return protagonist_pos; }
+
 private:
     // 控制器智能指针
     std::shared_ptr<Controller> controller;
@@ -152,6 +212,27 @@ private:
     // 设置日志和游戏输出的最大尺寸
     int min_win_width = 0;
     int min_win_height = 0;
+    // 固定的窗口大小，0 表示查询终端
+    int fixed_width = 0;
+    int fixed_height = 0;
+
+    // 终端大小，只在收到 SIGWINCH 之后重新查询
+    int term_width = 0;
+    int term_height = 0;
+    // 当前布局对应的终端大小和地图版本号，两者都不变时不需要重新计算布局
+    int layout_width = -1;
+    int layout_height = -1;
+    uint64_t layout_revision = 0;
+    bool layout_fits = false;
+    // 窗口大小发生了变化，由信号处理函数设置，在下一帧开始前处理
+    inline static volatile std::sig_atomic_t resized = 1;
+
+    // SIGWINCH 信号处理函数
+    static void onResize(int sig);
+    // 查询终端大小
+    void querySize();
+    // 根据终端大小和地图尺寸计算各区域的大小，返回窗口是否足够大
+    bool updateLayout();
 
     // 设置留白
     static constexpr int TOP_MARGIN    = 0;
@@ -175,57 +256,87 @@ private:
     inline const static std::string BMB = "\U00002534";
     inline const static std::string BRB = "\U0000256F";
 
-    inline const static std::string MOVHOME = "\x1b[H";
-    inline const static std::string MOVU    = "\x1bM";
-    inline const static std::string MOVD    = "\n";
-    inline const static std::string SAVECUS = "\x1b[s";
-    inline const static std::string LOADCUS = "\x1b[u";
-    inline const static std::string REASE_S = "\x1b[2J";
-
-    std::string uLines(const int& lines) const;
-    std::string dLines(const int& lines) const;
-    std::string rCols(const int& cols) const;
-    std::string lCols(const int& cols) const;
-    std::string gotoXY(const int& x, const int& y) const;
-
-    // 日志队列
-    std::deque<std::string> logs;
+    // 日志，容量等于日志区域的行数，超出的行覆盖最旧的行
+    RingBuffer<PaneLine> logs;
     int logs_height = 0;
     int logs_width = 0;
-    // 游戏输出队列
-    std::deque<std::string> game_outputs;
+    // 游戏输出，容量等于游戏输出区域的行数
+    RingBuffer<PaneLine> game_outputs;
     int puts_height = 0;
     int puts_width = 0;
 
-    // 出口和入口队列
+    // 主角所在的地图坐标
+    Position protagonist_pos {0, 0};
+
+    // 字符格缓冲区
+    Screen screen;
+    // 渲染后端
+    std::shared_ptr<Renderer> renderer;
+    // 缓冲区中游戏输出和日志已经占用的行数
+    int puts_drawn = 0;
+    int logs_drawn = 0;
+    // 上次绘制之后从顶部移出的行数，绘制时先滚动对应的区域
+    int puts_scrolled = 0;
+    int logs_scrolled = 0;
+    // 日志或游戏输出发生了变化，尚未写入 Screen
+    bool panes_dirty = false;
+    // Screen 中有尚未输出的内容
+    bool frame_pending = false;
+
+    // 出口和入口队列，保存地图坐标
     std::queue<Position> in_positions;
     std::queue<Position> out_positions;
 
+    // 预先绘制的地形，不含主角，坐标为地图坐标加 1
+    Screen terrain;
+    // 地形对应的 Map 版本号，0 表示尚未绘制
+    uint64_t terrain_revision = 0;
+
+    // 重新绘制地形
+    void buildTerrain();
+
     // 构造函数
     View();
 
-    // 获得光标位置
-    void get_cursor_position(int& x, int& y);
-
     void colorPrint(
             const std::string& text,
             const std::string& simple_color,
             const Rgb& rgb_color,
-            std::deque<std::string>& outputs,
-            const int& width);
+            RingBuffer<PaneLine>& outputs,
+            const int& width,
+            int& scrolled);
 
-    // 更新输出
+    // 标记输出区域需要重绘
     void invalidate();
 
-    // 中英字符串截断
-    size_t cutUTFString(const std::string& utf8_str, size_t& index, const int& width);
+    // 将日志和游戏输出写入缓冲区
+    void drawPanes();
+
+    // 把这一帧交给渲染后端输出
+    void flush();
+
+    // 固定使用的样式在构造时转换为编号
+    std::unordered_map<std::string, StyleId> simple_styles;
+    StyleId prompt_style = StyleTable::DEFAULT_STYLE;
+    StyleId protagonist_style = StyleTable::DEFAULT_STYLE;
+    StyleId in_style = StyleTable::DEFAULT_STYLE;
+    StyleId out_style = StyleTable::DEFAULT_STYLE;
+
+    // simple_color 不为空时使用加粗的 ANSI 颜色，否则使用 rgb_color
+    StyleId makeStyle(const std::string& simple_color, const Rgb& rgb_color) const;
+
+    // 中间分割线所在的列
+    int middleColumn() const { return LEFT_MARGIN + 1 + logs_width + 1; }
+
+    // 命令输入所在的行
+    int cmdLine() const { return screen.getHeight() - BOTTOM_MARGIN - 1; }
 
-    // 特殊字符输出
-    std::string charToSpecial(const int& x, const int& y, int& tx, int& ty);
+    // 特殊字符输出，返回的字形不含转义序列，颜色通过 style 返回
+    std::string charToSpecial(const int& x, const int& y, int& tx, int& ty, StyleId& style);
 
-    // 跳转到地图的某个位置
-    // ！不支持恢复光标位置
-    bool gotoMap(const Position& pos);
+    // 地图坐标对应的屏幕坐标（从 1 开始）
+    // 地图中每个格子在屏幕上都占一列，宽字符会占用后面的格子
+    Position mapToScreen(const Position& pos) const;
 };
 
 /*
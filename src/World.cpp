@@ -0,0 +1,109 @@
+/**
+ * @file World.cpp
+ */
+#include "World.h"
+#include <exception>
+#include <fstream>
+#include "Log.h"
+#include "Map.h"
+#include "MapPrefetcher.h"
+#include "Scene.h"
+
+World::World(const std::filesystem::path &scene_file, const bool &prefetch) : scene_file(scene_file) {
+    if (prefetch)
+        prefetcher = std::make_unique<MapPrefetcher>();
+}
+
+World::~World() = default;
+
+std::shared_ptr<Scene> World::getScene(const std::string &name) {
+    auto it = scenes.find(name);
+    if (it != scenes.end())
+        return it->second;
+
+    std::shared_ptr<Scene> scene;
+    if (scenes_loaded || loadScenes())
+        scene = std::make_shared<Scene>(name, scenes_json);
+    else
+        scene = std::make_shared<Scene>(name);
+    scenes.emplace(name, scene);
+    return scene;
+}
+
+std::shared_ptr<Map> World::getMap(const std::string &filename, const Position &pos) {
+    collectPrefetched();
+    auto it = maps.find(filename);
+    if (it != maps.end()) {
+        it->second->placeProtagonist(pos);
+        return it->second;
+    }
+
+    auto map = std::make_shared<Map>(filename, pos);
+    if (map->valid())
+        maps.emplace(filename, map);
+    return map;
+}
+
+size_t World::prefetchNeighbours(const std::string &name) {
+    size_t submitted = 0;
+    collectPrefetched();
+    for (const auto &[id, neighbour] : getScene(name)->exits) {
+        getScene(neighbour);
+        std::string filename = neighbour + ".txt";
+        if (!prefetcher || maps.count(filename) || pending.count(filename))
+            continue;
+        if (prefetcher->request(filename)) {
+            pending.insert(filename);
+            ++submitted;
+        }
+    }
+    return submitted;
+}
+
+void World::waitPrefetch() {
+    if (prefetcher)
+        prefetcher->wait();
+    collectPrefetched();
+}
+
+void World::collectPrefetched() {
+    if (!prefetcher || pending.empty())
+        return;
+    MapPrefetcher::Loaded loaded;
+    while (prefetcher->tryTake(loaded)) {
+        pending.erase(loaded.filename);
+        // 主线程可能已经同步加载过这张地图
+        if (loaded.map->valid())
+            maps.try_emplace(loaded.filename, std::move(loaded.map));
+    }
+    for (const auto &filename : prefetcher->takeDropped())
+        pending.erase(filename);
+}
+
+void World::clear() {
+    if (prefetcher)
+        prefetcher->wait();
+    collectPrefetched();
+    pending.clear();
+    scenes.clear();
+    maps.clear();
+    scenes_json = nullptr;
+    scenes_loaded = false;
+}
+
+bool World::loadScenes() {
+    std::ifstream file(scene_file);
+    if (!file.is_open()) {
+        GAME_LOG(WARN, "无法打开场景文件: " + scene_file.string());
+        return false;
+    }
+    try {
+        file >> scenes_json;
+    } catch (const std::exception &e) {
+        GAME_LOG(WARN, "场景文件解析失败: " + std::string(e.what()));
+        scenes_json = nullptr;
+        return false;
+    }
+    scenes_loaded = true;
+    return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file World.h
+ * @details 场景与地图缓存，场景切换时不再读取磁盘
+ */
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "json.hpp"
+#include "tools.h"
+
+class Scene;
+class Map;
+class MapPrefetcher;
+
+/**
+ * @brief 场景与地图缓存
+ * @details 每个场景和地图只在第一次进入时加载一次，scenes.json 也只解析一次，
+ *          之后切换场景只需要取出缓存的对象并重置主角的位置\n
+ *          地形、碰撞网格和实体索引在缓存的 Map 中保持不变，只有主角的位置随玩家移动
+ *          开启预加载后，进入一个场景时由 prefetchNeighbours 在后台加载相邻场景的地图，
+ *          第一次进入相邻场景也只需要从缓存中取出
+ * @note 无效的地图不会被缓存，修复地图文件后下一次进入会重新加载
+ */
+class World {
+public:
+    /**
+     * @param scene_file scenes.json 的路径
+     * @param prefetch 是否启动后台线程预加载相邻场景的地图
+     */
+    explicit World(const std::filesystem::path &scene_file, const bool &prefetch = false);
+
+    ~World();
+
+    World(const World &) = delete;
+    World &operator=(const World &) = delete;
+
+    /**
+     * @brief 获取场景，第一次获取时构造
+     * @param name 场景名称
+     */
+    std::shared_ptr<Scene> getScene(const std::string &name);
+
+    /**
+     * @brief 获取地图，第一次获取时加载，并把主角放到指定位置
+     * @param filename 地图文件名，规则与 Map 的构造函数相同
+     * @param pos 主角的坐标，为 {-1, -1} 时放到地图的出生点
+     */
+    std::shared_ptr<Map> getMap(const std::string &filename, const Position &pos = {-1, -1});
+
+    /**
+     * @brief 预加载一个场景的所有相邻场景
+     * @details 相邻场景由 scenes.json 中该场景的出口决定，场景本身直接构造，地图交给后台线程加载，
+     *          已经缓存或正在加载的地图不会重复提交；未开启预加载时只构造场景
+     * @param name 当前场景名称
+     * @return 提交给后台线程的地图数
+     */
+    size_t prefetchNeighbours(const std::string &name);
+
+    /**
+     * @brief 等待后台线程处理完所有已提交的地图，并把结果放入缓存
+     */
+    void waitPrefetch();
+
+    /**
+     * @brief 清空缓存，下一次获取时重新加载
+     */
+    void clear();
+
+    /**
+     * @brief 已经缓存的地图数量
+     */
+    size_t cachedMaps() const { return maps.size(); }
+
+    /**
+     * @brief 已经缓存的场景数量
+     */
+    size_t cachedScenes() const { return scenes.size(); }
+
+private:
+    std::filesystem::path scene_file;
+    // scenes.json 的内容
+    nlohmann::json scenes_json;
+    bool scenes_loaded = false;
+    std::unordered_map<std::string, std::shared_ptr<Scene>> scenes;
+    std::unordered_map<std::string, std::shared_ptr<Map>> maps;
+    // 已经提交给后台线程、还没有取回的地图
+    std::unordered_set<std::string> pending;
+    std::unique_ptr<MapPrefetcher> prefetcher;
+
+    /**
+     * @brief 读取并解析 scenes.json
+     * @return 读取或解析失败时返回 false，下次获取场景时会重新读取
+     */
+    bool loadScenes();
+
+    /**
+     * @brief 取回后台线程加载好的地图
+     */
+    void collectPrefetched();
+};
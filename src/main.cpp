@@ -3,10 +3,19 @@
 #include "View.h"
 #include "Controller.h"
 #include "Welcome.h"
+#include "FlightRecorder.h"
+#include "ReplayInput.h"
+#include "Map.h"
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <unordered_map>
 #include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 #if defined(_WIN32) && !defined(__linux__)
 #   include <windows.h>
 #   include <clocale>
@@ -84,6 +93,10 @@ void showMainHelp(const char* programName) {
     std::cout << "Available commands:" << std::endl;
     std::cout << "  run      启动游戏" << std::endl;
     std::cout << "  test     运行测试" << std::endl;
+    std::cout << "  decode-flight  解码飞行记录文件" << std::endl;
+    std::cout << "  bench-replay   无终端回放按键脚本并统计每条命令的延迟" << std::endl;
+    std::cout << "  compile-maps   检查所有地图并编译为二进制格式" << std::endl;
+    std::cout << "  lint-maps      多线程检查一个目录下的所有地图文件" << std::endl;
     std::cout << std::endl;
     std::cout << "Use `" << programName << " <command> --help` for more information about a command." << std::endl;
     std::cout << "Documentation: start docs/html/index.html (Windows)" << std::endl;
@@ -93,6 +106,44 @@ void showMainHelp(const char* programName) {
     std::cout << "[38;5;45mSimple usage: " << programName << " test[0m" << std::endl;
 }
 
+// 检查根目录和日志目录，日志目录不存在时创建，成功时返回 0
+int resolveDirs(const std::string& root_str, const std::string& log_str,
+                std::filesystem::path& root_dir, std::filesystem::path& log_dir) {
+    namespace fs = std::filesystem;
+    try {
+        root_dir = fs::path(root_str);
+        log_dir = fs::path(log_str);
+        
+        // 验证路径是否存在并且是一个目录
+        if (!fs::exists(root_dir)) {
+            std::cerr << "错误：指定的路径不存在 '" << root_dir << "'" << std::endl;
+            return 1;
+        }
+        if (fs::exists(log_dir) && !fs::is_directory(root_dir)) {
+            std::cerr << "错误：指定的路径不是一个目录 '" << log_dir << "'" << std::endl;
+            return 1;
+        }
+        if (!fs::exists(log_dir)) {
+            fs::create_directory(log_dir);
+        }
+        if (!fs::is_directory(root_dir)) {
+            std::cerr << "错误：指定的路径不是一个目录 '" << root_dir << "'" << std::endl;
+            return 1;
+        }
+        
+        // 转化为绝对路径
+        root_dir = fs::canonical(root_dir);
+        log_dir = fs::canonical(log_dir);
+    } catch (const fs::filesystem_error& e) {
+        std::cerr << "文件系统错误: " << e.what() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 // 处理 run 命令
 int handleRunCommand(int argc, char* argv[]) {
     namespace fs = std::filesystem;
@@ -104,13 +155,14 @@ int handleRunCommand(int argc, char* argv[]) {
     };
 
     std::string root_str = "./", level = "INFO", log_str = "logs/";
-    bool help = false;
+    bool help = false, scroll_regions = false;
     
     // 构建 run 命令的解析器
     using namespace Catch::clara;
     auto cli = Opt(root_str, "root directory")["-r"]["--root"]("所有配置文件的根目录(使用/)") |
                Opt(log_str, "log directory")["-l"]["--logs"]("日志文件输出目录(使用/)") |
-               Opt(level, "log level")["-g"]["--glevel"]("日志等级\n决定日志的详细程度") |
+               Opt(level, "log level")["-g"]["--glevel"]("日志等级(DEBUG/INFO/WARN/ERR)\n决定日志的详细程度，只有 DEBUG 等级会把 DEBUG 消息写入 Debug.log") |
+               Opt(scroll_regions)["--scroll-regions"]("使用终端的滚动区域滚动输出，需要终端支持 DECSLRM（例如 xterm）") |
                Help(help);
     
     // 解析 run 命令的参数
@@ -126,35 +178,7 @@ int handleRunCommand(int argc, char* argv[]) {
     
     // 处理路径
     fs::path root_dir("."), log_dir("./logs");
-    try {
-        root_dir = fs::path(root_str);
-        log_dir = fs::path(log_str);
-        
-        // 验证路径是否存在并且是一个目录
-        if (!fs::exists(root_dir)) {
-            std::cerr << "错误：指定的路径不存在 '" << root_dir << "'" << std::endl;
-            return 1;
-        }
-        if (fs::exists(log_dir) && !fs::is_directory(root_dir)) {
-            std::cerr << "错误：指定的路径不是一个目录 '" << log_dir << "'" << std::endl;
-            return 1;
-        }
-        if (!fs::exists(log_dir)) {
-            fs::create_directory(log_dir);
-        }
-        if (!fs::is_directory(root_dir)) {
-            std::cerr << "错误：指定的路径不是一个目录 '" << root_dir << "'" << std::endl;
-            return 1;
-        }
-        
-        // 转化为绝对路径
-        root_dir = fs::canonical(root_dir);
-        log_dir = fs::canonical(log_dir);
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "文件系统错误: " << e.what() << std::endl;
-        return 1;
-    } catch (const std::exception& e) {
-        std::cerr << "错误: " << e.what() << std::endl;
+    if (resolveDirs(root_str, log_str, root_dir, log_dir) != 0) {
         return 1;
     }
 
@@ -163,6 +187,7 @@ int handleRunCommand(int argc, char* argv[]) {
     
     // 创建控制器并运行游戏
     auto controller = Controller::getInstance(levels[level], log_dir, root_dir);
+    View::getInstance()->setScrollRegions(scroll_regions);
     int runcode = controller->run();
     
     // 确保光标正常显示
@@ -183,6 +208,309 @@ int handleTestCommand(int argc, char* argv[]) {
     return session.run();
 }
 
+// 处理 decode-flight 命令
+int handleDecodeFlightCommand(int argc, char* argv[]) {
+    std::string file_str;
+    bool help = false;
+
+    using namespace Catch::clara;
+    auto cli = Arg(file_str, "file")("导出的飞行记录文件(flight-*.bin)") |
+               Help(help);
+
+    auto result = cli.parse(Args(argc, argv));
+    if (!result || help || file_str.empty()) {
+        std::cout << "================================== Decode Flight Help =========================" << std::endl;
+        std::cout << "Usage: " << argv[0] << " decode-flight <file>" << std::endl;
+        std::cout << cli << std::endl;
+        std::cout << "================================== End =======================================" << std::endl;
+        if (!result) std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+        return 1;
+    }
+
+    std::ifstream fin(file_str, std::ios::binary);
+    if (!fin.is_open()) {
+        std::cerr << "错误：无法打开文件 '" << file_str << "'" << std::endl;
+        return 1;
+    }
+    Message msg = FlightRecorder::decode(fin, std::cout);
+    if (msg.status) {
+        std::cerr << "错误：" << msg.msg << std::endl;
+    }
+    return msg.status < 0 ? 1 : 0;
+}
+
+// 处理 bench-replay 命令
+int handleBenchReplayCommand(int argc, char* argv[]) {
+    namespace fs = std::filesystem;
+    std::string script_str, root_str = "./", log_str = "logs/", capture_str;
+    int width = 220, height = 70;
+    bool help = false, scroll_regions = false, headless = false;
+
+    using namespace Catch::clara;
+    auto cli = Arg(script_str, "script")("按键脚本，格式见 ReplayInput.h") |
+               Opt(root_str, "root directory")["-r"]["--root"]("所有配置文件的根目录(使用/)") |
+               Opt(log_str, "log directory")["-l"]["--logs"]("日志文件输出目录(使用/)") |
+               Opt(capture_str, "file")["-c"]["--capture"]("把游戏画面写入该文件，默认丢弃") |
+               Opt(width, "width")["--width"]("虚拟终端宽度") |
+               Opt(height, "height")["--height"]("虚拟终端高度") |
+               Opt(scroll_regions)["--scroll-regions"]("使用终端的滚动区域滚动输出") |
+               Opt(headless)["--headless"]("不绘制画面，只测量游戏逻辑") |
+               Help(help);
+
+    auto result = cli.parse(Args(argc, argv));
+    if (!result || help || script_str.empty()) {
+        std::cout << "================================== Bench Replay Help ==========================" << std::endl;
+        std::cout << "Usage: " << argv[0] << " bench-replay <script> [options]" << std::endl;
+        std::cout << cli << std::endl;
+        std::cout << "================================== End =======================================" << std::endl;
+        if (!result) std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+        return 1;
+    }
+
+    std::ifstream script(script_str);
+    if (!script.is_open()) {
+        std::cerr << "错误：无法打开脚本 '" << script_str << "'" << std::endl;
+        return 1;
+    }
+    auto replay = std::make_shared<ReplayInput>(script);
+    if (!replay->valid()) {
+        std::cerr << "错误：" << replay->getValidMsg() << std::endl;
+        return 1;
+    }
+
+    fs::path root_dir("."), log_dir("./logs");
+    if (resolveDirs(root_str, log_str, root_dir, log_dir) != 0) {
+        return 1;
+    }
+
+    std::ofstream capture_file;
+    if (!capture_str.empty()) {
+        capture_file.open(capture_str, std::ios::binary);
+        if (!capture_file.is_open()) {
+            std::cerr << "错误：无法写入 '" << capture_str << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    // 所有绘制都写入 capture，不经过终端
+    OutputCapture capture(capture_file.is_open() ? &capture_file : nullptr);
+    auto controller = Controller::getInstance(Controller::LogLevel::INFO, log_dir, root_dir);
+    controller->input = replay;
+    auto start = std::chrono::steady_clock::now();
+    auto old_buf = std::cout.rdbuf(&capture);
+    auto view = View::getInstance();
+    std::shared_ptr<TerminalRenderer> terminal;
+    std::shared_ptr<NullRenderer> null_renderer;
+    if (headless) {
+        null_renderer = std::make_shared<NullRenderer>(width, height);
+        view->setRenderer(null_renderer);
+    } else {
+        terminal = std::make_shared<TerminalRenderer>();
+        terminal->getWriter().setStream(&std::cout);
+        view->setRenderer(terminal);
+    }
+    view->setFixedSize(width, height);
+    view->setScrollRegions(scroll_regions);
+    int runcode = controller->run();
+    std::cout.flush();
+    std::cout.rdbuf(old_buf);
+    if (terminal)
+        terminal->getWriter().setStream(nullptr);
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    Message msg = replay->report(std::cout);
+    std::cout << "wall " << wall_ms << " ms, output " << capture.bytes() << " bytes, "
+              << capture.flushes() << " flushes" << std::endl;
+    if (headless) {
+        std::cout << "frames " << null_renderer->getFrames() << " (headless)" << std::endl;
+    } else {
+        const auto& stats = terminal->getWriter().getStats();
+        std::cout << "frames " << stats.frames << ", " << stats.bytes << " bytes ("
+                  << (stats.frames ? stats.bytes / stats.frames : 0) << " per frame, max "
+                  << stats.max_frame_bytes << "), " << stats.syscalls << " writes" << std::endl;
+    }
+    if (msg.status) {
+        std::cerr << "错误：" << msg.msg << std::endl;
+        return 1;
+    }
+    return runcode;
+}
+
+// 处理 compile-maps 命令
+int handleCompileMapsCommand(int argc, char* argv[]) {
+    namespace fs = std::filesystem;
+    std::string root_str = "./", log_str = "logs/";
+    int repeat = 20;
+    bool help = false;
+
+    using namespace Catch::clara;
+    auto cli = Opt(root_str, "root directory")["-r"]["--root"]("所有配置文件的根目录(使用/)") |
+               Opt(log_str, "log directory")["-l"]["--logs"]("日志文件输出目录(使用/)") |
+               Opt(repeat, "times")["--repeat"]("测量加载时间时每张地图加载的次数") |
+               Help(help);
+
+    auto result = cli.parse(Args(argc, argv));
+    if (!result || help || repeat <= 0) {
+        std::cout << "================================== Compile Maps Help ==========================" << std::endl;
+        std::cout << "Usage: " << argv[0] << " compile-maps [options]" << std::endl;
+        std::cout << cli << std::endl;
+        std::cout << "================================== End =======================================" << std::endl;
+        if (!result) std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+        return 1;
+    }
+
+    fs::path root_dir("."), log_dir("./logs");
+    if (resolveDirs(root_str, log_str, root_dir, log_dir) != 0) {
+        return 1;
+    }
+    Controller::getInstance(Controller::LogLevel::INFO, log_dir, root_dir);
+
+    std::vector<std::string> names;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(root_dir / "maps", error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt")
+            names.push_back(entry.path().filename().string());
+    }
+    if (error) {
+        std::cerr << "错误：无法读取 '" << (root_dir / "maps").string() << "'" << std::endl;
+        return 1;
+    }
+    std::sort(names.begin(), names.end());
+
+    // 加载 repeat 次的平均耗时(us)
+    auto timeLoads = [repeat](const std::string& name, bool& compiled) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; ++i) {
+            auto map = std::make_unique<Map>(name);
+            compiled = map->isCompiled();
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeat;
+    };
+
+    int failures = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& name : names) {
+        size_t bytes = 0;
+        Message msg = Map::compile(name, bytes);
+        if (msg.status) {
+            std::cerr << "错误：" << msg.msg << std::endl;
+            ++failures;
+            continue;
+        }
+        bool compiled = false;
+        Map::useCompiled(false);
+        double text_us = timeLoads(name, compiled);
+        Map::useCompiled(true);
+        double binary_us = timeLoads(name, compiled);
+        if (!compiled) {
+            std::cerr << "错误：" << name << " 编译后仍然从文本加载" << std::endl;
+            ++failures;
+            continue;
+        }
+        std::cout << std::left << std::setw(16) << name << std::right
+                  << "text " << std::setw(8) << text_us << " us, compiled " << std::setw(6) << binary_us
+                  << " us, " << bytes << " bytes" << std::endl;
+    }
+    std::cout << names.size() - failures << "/" << names.size() << " maps compiled" << std::endl;
+    return failures ? 1 : 0;
+}
+
+// 处理 lint-maps 命令
+int handleLintMapsCommand(int argc, char* argv[]) {
+    namespace fs = std::filesystem;
+    std::string dir_str, root_str = "./", log_str = "logs/";
+    int jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool compile = false, verbose = false, help = false;
+
+    using namespace Catch::clara;
+    auto cli = Arg(dir_str, "dir")("地图目录，默认为 <root>/maps") |
+               Opt(jobs, "threads")["-j"]["--jobs"]("线程数，默认为 CPU 核数") |
+               Opt(compile)["--compile"]("把检查通过的地图编译为同一目录下的 .bin 文件") |
+               Opt(verbose)["-v"]["--verbose"]("同时列出检查通过的地图") |
+               Opt(root_str, "root directory")["-r"]["--root"]("所有配置文件的根目录(使用/)") |
+               Opt(log_str, "log directory")["-l"]["--logs"]("日志文件输出目录(使用/)") |
+               Help(help);
+
+    auto result = cli.parse(Args(argc, argv));
+    if (!result || help || jobs <= 0) {
+        std::cout << "================================== Lint Maps Help =============================" << std::endl;
+        std::cout << "Usage: " << argv[0] << " lint-maps [dir] [options]" << std::endl;
+        std::cout << cli << std::endl;
+        std::cout << "================================== End =======================================" << std::endl;
+        if (!result) std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+        return 1;
+    }
+
+    fs::path root_dir("."), log_dir("./logs");
+    if (resolveDirs(root_str, log_str, root_dir, log_dir) != 0) {
+        return 1;
+    }
+    Controller::getInstance(Controller::LogLevel::INFO, log_dir, root_dir);
+    fs::path dir = dir_str.empty() ? root_dir / "maps" : fs::path(dir_str);
+
+    std::vector<fs::path> files;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(dir, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt")
+            files.push_back(entry.path());
+    }
+    if (error) {
+        std::cerr << "错误：无法读取 '" << dir.string() << "'" << std::endl;
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    struct Result {
+        Message msg;
+        Position where {-1, -1};
+        double us = 0;
+    };
+    std::vector<Result> results(files.size());
+    std::atomic<size_t> next {0};
+    auto start = std::chrono::steady_clock::now();
+    // 每个线程不断领取下一个文件，结果写入各自的下标，不需要加锁
+    auto worker = [&]() {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            auto begin = std::chrono::steady_clock::now();
+            results[i].msg = Map::lint(files[i], results[i].where, compile);
+            results[i].us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        }
+    };
+    jobs = static_cast<int>(std::min<size_t>(jobs, std::max<size_t>(files.size(), 1)));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failures = 0;
+    double total_us = 0, max_us = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < files.size(); ++i) {
+        const auto& r = results[i];
+        total_us += r.us;
+        max_us = std::max(max_us, r.us);
+        if (r.msg.status) {
+            ++failures;
+            // 与编译器相同的 file:line:column 格式，方便编辑器跳转
+            std::cout << files[i].string();
+            if (r.where.x > 0)
+                std::cout << ":" << r.where.x;
+            if (r.where.x > 0 && r.where.y > 0)
+                std::cout << ":" << r.where.y;
+            std::cout << ": error: " << r.msg.msg << " (" << r.us << " us)" << std::endl;
+        } else if (verbose) {
+            std::cout << files[i].string() << ": ok (" << r.us << " us)" << std::endl;
+        }
+    }
+    std::cout << files.size() << " maps, " << failures << " with errors, " << wall_ms << " ms on "
+              << jobs << " threads (" << (files.empty() ? 0 : total_us / files.size()) << " us per map, max "
+              << max_us << " us)" << std::endl;
+    return failures ? 1 : 0;
+}
+
 int main(int argc, char* argv[]) {
     // 检查运行环境
     envCheck();
@@ -206,6 +534,14 @@ int main(int argc, char* argv[]) {
     } else if (command == "test") {
         // 处理 test 命令，跳过第一个参数（程序名）和第二个参数（命令名）
         return handleTestCommand(argc - 1, argv + 1);
+    } else if (command == "decode-flight") {
+        return handleDecodeFlightCommand(argc - 1, argv + 1);
+    } else if (command == "bench-replay") {
+        return handleBenchReplayCommand(argc - 1, argv + 1);
+    } else if (command == "compile-maps") {
+        return handleCompileMapsCommand(argc - 1, argv + 1);
+    } else if (command == "lint-maps") {
+        return handleLintMapsCommand(argc - 1, argv + 1);
     } else if (command == "--help" || command == "-h") {
         // 显示主帮助信息
         showMainHelp(argv[0]);
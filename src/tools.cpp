@@ -83,6 +83,10 @@ std::string getStr(EventType type)
         return "帮助信息";
     case EventType::USE:
         return "使用物品";
+    case EventType::DUMP:
+        return "导出飞行记录";
+    case EventType::GOTO:
+        return "自动寻路";
     case EventType::QUIT:
         return "退出游戏";
     case EventType::NONE:
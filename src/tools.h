@@ -27,6 +27,8 @@ enum class EventType
     HELP,      ///< 帮助信息
     USE,       ///< 使用物品
     EXAM,      ///< 期末考试
+    DUMP,      ///< 导出飞行记录
+    GOTO,      ///< 自动走到出口或 NPC
     QUIT,      ///< 退出游戏
     NONE       ///< 无事件
 };
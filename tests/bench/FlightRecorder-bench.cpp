@@ -0,0 +1,25 @@
+/**
+ * @brief 飞行记录仪的性能测试
+ * @details 每个 BENCHMARK 写入 1000 条记录，结果除以 1000 即为单条记录的开销
+ */
+#include "catch.hpp"
+#include "FlightRecorder.h"
+
+TEST_CASE("Cost of a flight recorder record", "[.][bench][flight]") {
+    auto& recorder = FlightRecorder::getInstance();
+    constexpr int CALLS = 1000;
+
+    BENCHMARK("record(EVENT) x1000") {
+        for (int i = 0; i < CALLS; ++i) {
+            recorder.record(FlightRecorder::Kind::EVENT, static_cast<int>(EventType::MOVE), {i, i}, i);
+        }
+        return recorder.total();
+    };
+
+    BENCHMARK("record(LOG) with 32 byte text x1000") {
+        for (int i = 0; i < CALLS; ++i) {
+            recorder.record(FlightRecorder::Kind::LOG, 0, {i, i}, -1, 0, "NPCid: 42 ----------------------");
+        }
+        return recorder.total();
+    };
+}
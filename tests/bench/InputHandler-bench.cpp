@@ -0,0 +1,51 @@
+/**
+ * @brief 空闲时 InputHandler 的 CPU 占用
+ * @details 玩家不按键时 waitKeyDown 应当阻塞在 poll 上，几乎不占用 CPU。
+ *          用管道代替终端，另一个线程在 IDLE_MS 之后写入一个按键，
+ *          统计等待线程在这段时间内消耗的 CPU 时间
+ */
+#include "catch.hpp"
+#include "InputHandler.h"
+#if defined(__linux__)
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int IDLE_MS = 1000;
+
+    double threadCpuMs() {
+        struct rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+    }
+}
+
+TEST_CASE("Idle CPU usage of InputHandler::waitKeyDown", "[.][bench][input]") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    InputHandler input(fds[0]);
+
+    std::thread player([fd = fds[1]] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+        (void)!write(fd, "w", 1);
+    });
+
+    auto wall_start = std::chrono::steady_clock::now();
+    double cpu_start = threadCpuMs();
+    int key = input.waitKeyDown();
+    double cpu_ms = threadCpuMs() - cpu_start;
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    player.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    std::cout << "waitKeyDown idle: wall " << wall_ms << " ms, cpu " << cpu_ms << " ms ("
+              << 100.0 * cpu_ms / wall_ms << "%)" << std::endl;
+    REQUIRE(key == 'w');
+    REQUIRE(cpu_ms < wall_ms * 0.01);
+}
+#endif
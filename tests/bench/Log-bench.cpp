@@ -0,0 +1,44 @@
+/**
+ * @brief 日志前端的性能测试
+ * @details 对比运行时被过滤的 GAME_LOG 与旧写法（先拼接字符串再交给 log 过滤）的开销，
+ *          每个 BENCHMARK 调用 1000 次，结果除以 1000 即为单次调用的开销
+ */
+#include "catch.hpp"
+#include "Log.h"
+#include <string>
+
+TEST_CASE("Cost of a filtered DEBUG log call", "[.][bench][log]") {
+    Controller::getInstance();
+    REQUIRE_FALSE(Controller::enabled(Controller::LogLevel::DEBUG));
+    constexpr int CALLS = 1000;
+    int npc_id = 42;
+
+    BENCHMARK("empty loop x1000") {
+        int sum = 0;
+        for (int i = 0; i < CALLS; ++i) {
+            sum += npc_id;
+        }
+        return sum;
+    };
+
+    BENCHMARK("GAME_LOG(DEBUG) filtered at runtime x1000") {
+        int sum = 0;
+        for (int i = 0; i < CALLS; ++i) {
+            GAME_LOG(DEBUG, "NPCid: " + std::to_string(npc_id + i));
+            sum += npc_id;
+        }
+        return sum;
+    };
+
+    BENCHMARK("eager message + runtime filter x1000") {
+        size_t sum = 0;
+        for (int i = 0; i < CALLS; ++i) {
+            std::string msg = "NPCid: " + std::to_string(npc_id + i);
+            if (Controller::enabled(Controller::LogLevel::DEBUG)) {
+                Controller::getInstance()->log(Controller::LogLevel::DEBUG, msg);
+            }
+            sum += msg.size();
+        }
+        return sum;
+    };
+}
@@ -0,0 +1,108 @@
+/**
+ * @brief Map 碰撞检测的性能测试
+ * @details 在 Center 地图上比较碰撞网格与逐格扫描的单次检测开销，测量半径查询，
+ *          主角左右来回移动的单步开销，从文本与二进制文件加载地图的开销，在共享地形上开始新会话的开销，
+ *          以及建立距离场与查询缓存路线的开销
+ * @note 需要在项目根目录下运行，以便读取 maps/
+ */
+#include "catch.hpp"
+#include "Map.h"
+#include <memory>
+#include <vector>
+
+TEST_CASE("Cost of collision checks and protagonist steps", "[.][bench][map]") {
+    Map map("Center.txt");
+    REQUIRE(map.valid());
+    std::vector<Position> cells;
+    for (int i = 0; i < map.getMaxHeight(); ++i)
+        for (int j = 0; j + 1 < map.getMaxWidth(); ++j)
+            cells.emplace_back(i, j);
+    int row = map.getPos().x;
+
+    BENCHMARK("detectCollision every cell") {
+        int hits = 0;
+        for (const auto& cell : cells)
+            hits += map.detectCollision(cell) != -1;
+        return hits;
+    };
+
+    BENCHMARK("scanCollision every cell") {
+        int hits = 0;
+        for (const auto& cell : cells)
+            hits += map.scanCollision(cell, cell.x != row) != -1;
+        return hits;
+    };
+
+    Position center = map.getPos();
+    BENCHMARK("entitiesWithin radius 5") {
+        return map.entitiesWithin(center, 5);
+    };
+
+    // 找一个可以左右来回走的位置
+    EventType event = EventType::NONE;
+    int id = -1;
+    int direction = 1;
+    if (map.moveProtagonist(direction, event, id).status != 0)
+        direction = 3;
+    BENCHMARK("moveProtagonist step") {
+        direction ^= 2;
+        return map.moveProtagonist(direction, event, id);
+    };
+}
+
+TEST_CASE("Cost of loading a map from text and compiled files", "[.][bench][map]") {
+    size_t bytes = 0;
+    REQUIRE(Map::compile("Center.txt", bytes).status == 0);
+
+    Map::useCompiled(false);
+    BENCHMARK("load Center.txt (text)") {
+        return std::make_unique<Map>("Center.txt");
+    };
+    Map::useCompiled(true);
+    REQUIRE(Map("Center.txt").isCompiled());
+    BENCHMARK("load Center.txt (compiled)") {
+        return std::make_unique<Map>("Center.txt");
+    };
+}
+
+TEST_CASE("Cost of starting a session on a shared terrain", "[.][bench][map]") {
+    Map loaded("Center.txt");
+    REQUIRE(loaded.valid());
+    auto terrain = loaded.getTerrain();
+    WARN("terrain bytes: " << sizeof(Map::Terrain) << ", session bytes: " << sizeof(Map));
+
+    BENCHMARK("load Center.txt") {
+        return std::make_unique<Map>("Center.txt");
+    };
+    BENCHMARK("session on shared terrain") {
+        return std::make_unique<Map>(terrain);
+    };
+}
+
+TEST_CASE("Cost of route queries with cached distance fields", "[.][bench][map]") {
+    Map map("Center.txt");
+    REQUIRE(map.valid());
+    // 选择路线最长的出口
+    int exit_id = -1;
+    size_t longest = 0;
+    std::vector<int> directions;
+    for (const auto& entity : map.getEntities()) {
+        if (entity.type == Map::EntityType::EXIT && map.goTo(entity.id, 2, directions).status == 0 &&
+            directions.size() > longest) {
+            exit_id = entity.id;
+            longest = directions.size();
+        }
+    }
+    REQUIRE(exit_id != -1);
+    WARN("route length: " << longest);
+
+    BENCHMARK_ADVANCED("goTo on a fresh terrain")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::unique_ptr<Map>> maps;
+        for (int i = 0; i < meter.runs(); ++i)
+            maps.push_back(std::make_unique<Map>("Center.txt"));
+        meter.measure([&](int i) { return maps[i]->goTo(exit_id, 2, directions).status; });
+    };
+    BENCHMARK("goTo with a cached field") {
+        return map.goTo(exit_id, 2, directions).status;
+    };
+}
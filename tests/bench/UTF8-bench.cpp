@@ -0,0 +1,59 @@
+/**
+ * @brief UTF-8 显示宽度的性能测试
+ * @details 在中英混排的 NPC 对话上比较逐字节判断长度的旧写法和 UTF8 的查表实现
+ */
+#include "catch.hpp"
+#include "UTF8.h"
+#include <string>
+
+namespace {
+    // View::cutUTFString 和 Store::get_utf_empty 原来的写法：3 字节字符按 2 列，4 字节字符无法处理
+    size_t legacyWidth(const std::string& text) {
+        size_t length = 0;
+        for (size_t index = 0; index < text.length(); ) {
+            unsigned char c = static_cast<unsigned char>(text[index]);
+            if (c < 0x80) {
+                index += 1, length += 1;
+            } else if ((c & 0xE0) == 0xC0) {
+                index += 2, length += 1;
+            } else if ((c & 0xF0) == 0xE0) {
+                index += 3, length += 2;
+            } else {
+                return 0xFFFF;
+            }
+        }
+        return length;
+    }
+}
+
+TEST_CASE("Cost of measuring mixed Chinese and ASCII text", "[.][bench][utf8]") {
+    std::string mixed, ascii, chinese;
+    for (int i = 0; i < 32; ++i) {
+        mixed += "参加羽毛球锻炼需要消耗5金币并获得10体力，但会花费更多时间 (badminton costs 5 coins). ";
+        ascii += "The PE teacher says badminton costs 5 coins and gives 10 stamina points. ";
+        chinese += "参加羽毛球锻炼需要消耗金币并获得体力，但会花费更多时间。";
+    }
+    REQUIRE(UTF8::width(mixed) == legacyWidth(mixed));
+
+    BENCHMARK("legacy byte loop, mixed") {
+        return legacyWidth(mixed);
+    };
+    BENCHMARK("UTF8::width, mixed") {
+        return UTF8::width(mixed);
+    };
+    BENCHMARK("legacy byte loop, ascii") {
+        return legacyWidth(ascii);
+    };
+    BENCHMARK("UTF8::width, ascii") {
+        return UTF8::width(ascii);
+    };
+    BENCHMARK("UTF8::width, chinese") {
+        return UTF8::width(chinese);
+    };
+    BENCHMARK("UTF8::cut into 80-column lines, mixed") {
+        size_t lines = 0;
+        for (size_t index = 0; index < mixed.size(); ++lines)
+            UTF8::cut(mixed, index, 80);
+        return lines;
+    };
+}
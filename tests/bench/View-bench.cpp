@@ -0,0 +1,118 @@
+/**
+ * @brief View 输出面板的性能测试
+ * @details 在 220x70 的虚拟终端上绘制 Center 地图，画面写入只计数的输出流，
+ *          测量全局重绘，以及长 NPC 对话和商店翻页从 printQuestion/printOptions 到 present() 输出一帧的开销\n
+ *          同样的操作再用无界面后端测一次，得到不含绘制的开销
+ * @note 需要在项目根目录下运行，以便读取 maps/ 和 .config/
+ */
+#include "catch.hpp"
+#include "Controller.h"
+#include "Map.h"
+#include "ReplayInput.h"
+#include "Store.h"
+#include "View.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+TEST_CASE("Cost of printing to the View panes", "[.][bench][view]") {
+    auto controller = Controller::getInstance();
+    controller->map = std::make_shared<Map>("Center.txt");
+    REQUIRE(controller->map->valid());
+    auto view = View::getInstance();
+    auto old_renderer = view->getRenderer();
+    OutputCapture capture;
+    std::ostream null_out(&capture);
+    auto terminal = std::make_shared<TerminalRenderer>();
+    terminal->getWriter().setStream(&null_out);
+    view->setRenderer(terminal);
+    view->setFixedSize(220, 70);
+    REQUIRE(view->reDraw());
+    view->present();
+
+    std::string prompt;
+    for (int i = 0; i < 8; ++i)
+        prompt += "参加羽毛球锻炼需要消耗5金币并获得10体力，但会花费更多时间 (badminton costs 5 coins). ";
+
+    BENCHMARK("printQuestion long NPC prompt") {
+        view->printQuestion("体育老师", prompt, "", Rgb(255, 255, 0));
+        view->present();
+    };
+
+    BENCHMARK("reDraw Center map") {
+        view->reDraw();
+        view->present();
+    };
+
+    Store store;
+    BENCHMARK("Store::showProducts page") {
+        store.showProducts(0);
+        view->present();
+    };
+
+    view->setRenderer(std::make_shared<NullRenderer>(220, 70));
+    REQUIRE(view->reDraw());
+    view->present();
+
+    BENCHMARK("printQuestion long NPC prompt (headless)") {
+        view->printQuestion("体育老师", prompt, "", Rgb(255, 255, 0));
+        view->present();
+    };
+
+    BENCHMARK("reDraw Center map (headless)") {
+        view->reDraw();
+        view->present();
+    };
+
+    BENCHMARK("Store::showProducts page (headless)") {
+        store.showProducts(0);
+        view->present();
+    };
+
+    view->setRenderer(old_renderer);
+    view->clearOutputs();
+    controller->map = nullptr;
+}
+
+#if defined(__GLIBC__)
+TEST_CASE("View panes keep a constant heap footprint", "[.][bench][view]") {
+    auto controller = Controller::getInstance();
+    controller->map = std::make_shared<Map>("Center.txt");
+    REQUIRE(controller->map->valid());
+    auto view = View::getInstance();
+    auto old_renderer = view->getRenderer();
+    view->setRenderer(std::make_shared<NullRenderer>(220, 70));
+    view->setFixedSize(220, 70);
+    view->clearOutputs();
+    REQUIRE(view->reDraw());
+    view->present();
+
+    const std::string log_line = "在图书馆学习了一小时，获得 5 点学识 (studied for an hour)";
+    const std::string question = "参加羽毛球锻炼需要消耗5金币并获得10体力，但会花费更多时间 (badminton costs 5 coins). ";
+    auto session = [&](const int& events) {
+        for (int i = 0; i < events; ++i) {
+            view->printLog(log_line, "green");
+            view->printQuestion("体育老师", question, "yellow");
+            view->present();
+        }
+    };
+    // 先把所有槽位写满，之后只复用槽位
+    session(200);
+    size_t before = mallinfo2().uordblks;
+    session(100000);
+    size_t after = mallinfo2().uordblks;
+    std::cout << "heap in use: " << before << " -> " << after << " bytes after 100000 events" << std::endl;
+    REQUIRE(after <= before);
+
+    BENCHMARK("printLog + printQuestion + present (headless)") {
+        session(1);
+    };
+
+    view->setRenderer(old_renderer);
+    view->clearOutputs();
+    controller->map = nullptr;
+}
+#endif
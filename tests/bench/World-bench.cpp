@@ -0,0 +1,101 @@
+/**
+ * @brief 场景切换的性能测试
+ * @details 在 Center 和 Canteen 之间来回切换，比较每次重新读取 scenes.json 和地图文件
+ *          与从 World 缓存中取出的开销；再统计第一次进入相邻场景的延迟分布，比较
+ *          同步加载、后台预加载与缓存命中三种情况
+ * @note 需要在项目根目录下运行，以便读取 maps/ 和 .config/
+ */
+#include "catch.hpp"
+#include "Controller.h"
+#include "Map.h"
+#include "Scene.h"
+#include "World.h"
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+    // 以 2 的幂为边界的延迟直方图，单位为纳秒
+    struct LatencyHistogram {
+        std::array<uint64_t, 32> buckets {};
+        uint64_t count = 0;
+
+        void add(const uint64_t& ns) {
+            int bucket = 0;
+            while (bucket + 1 < static_cast<int>(buckets.size()) && (1ull << (bucket + 1)) <= ns)
+                ++bucket;
+            ++buckets[bucket];
+            ++count;
+        }
+
+        void print(const std::string& title) const {
+            std::cout << title << " (" << count << " entries)" << std::endl;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                if (!buckets[i])
+                    continue;
+                std::cout << "  >= " << std::setw(9) << (1ull << i) << " ns  " << std::setw(5) << buckets[i] << " "
+                          << std::string(buckets[i] * 40 / count, '#') << std::endl;
+            }
+        }
+    };
+
+    uint64_t elapsedNs(const std::chrono::steady_clock::time_point& start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TEST_CASE("Cost of a scene transition", "[.][bench][world]") {
+    const std::string names[2] = {"Center", "Canteen"};
+    int next = 0;
+
+    BENCHMARK("JUMP reloading Scene and Map") {
+        const std::string& name = names[next ^= 1];
+        auto scene = std::make_shared<Scene>(name);
+        auto map = std::make_shared<Map>(name + ".txt", Position(-1, -1));
+        return map->getPos().x + static_cast<int>(scene->exits.size());
+    };
+
+    World world(Controller::getInstance()->getRootDir() / ".config" / "scenes.json");
+    BENCHMARK("JUMP through World cache") {
+        const std::string& name = names[next ^= 1];
+        auto scene = world.getScene(name);
+        auto map = world.getMap(name + ".txt");
+        return map->getPos().x + static_cast<int>(scene->exits.size());
+    };
+}
+
+TEST_CASE("First entry into neighbouring scenes", "[.][bench][world]") {
+    const auto scene_file = Controller::getInstance()->getRootDir() / ".config" / "scenes.json";
+    constexpr int ROUNDS = 50;
+    LatencyHistogram cold, prefetched, warm;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (const bool prefetch : {false, true}) {
+            World world(scene_file, prefetch);
+            world.getMap("Center.txt");
+            world.prefetchNeighbours("Center");
+            // 玩家走到出口之前，后台线程已经加载完
+            world.waitPrefetch();
+            for (const auto& [id, name] : world.getScene("Center")->exits) {
+                auto start = std::chrono::steady_clock::now();
+                world.getScene(name);
+                world.getMap(name + ".txt");
+                (prefetch ? prefetched : cold).add(elapsedNs(start));
+
+                if (!prefetch) {
+                    start = std::chrono::steady_clock::now();
+                    world.getScene(name);
+                    world.getMap(name + ".txt");
+                    warm.add(elapsedNs(start));
+                }
+            }
+        }
+    }
+    cold.print("first entry, loaded on demand");
+    prefetched.print("first entry, prefetched");
+    warm.print("second entry, cached");
+    REQUIRE(prefetched.count == cold.count);
+}
@@ -0,0 +1,71 @@
+#include "catch.hpp"
+#include "FlightRecorder.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    size_t countRecordLines(const std::string& text) {
+        std::istringstream in(text);
+        std::string line;
+        size_t n = 0;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line[0] == '+') ++n;
+        }
+        return n;
+    }
+}
+
+TEST_CASE("FlightRecorder dumps and decodes recent records", "[flight]") {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "oucsurvsim-flight-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    auto& recorder = FlightRecorder::getInstance();
+
+    SECTION("a dump round-trips through decode") {
+        recorder.record(FlightRecorder::Kind::EVENT, static_cast<int>(EventType::MOVE), {3, 4}, 7);
+        recorder.record(FlightRecorder::Kind::LOG, 3, {3, 4}, -1, 0,
+                        "a message that is much longer than forty bytes and gets truncated");
+        fs::path file_path;
+        Message msg = recorder.dump(dir, file_path);
+        REQUIRE(msg.status == 0);
+        REQUIRE(fs::exists(file_path));
+
+        std::ifstream fin(file_path, std::ios::binary);
+        std::ostringstream out;
+        REQUIRE(FlightRecorder::decode(fin, out).status == 0);
+        const std::string text = out.str();
+        REQUIRE(text.find("EVENT 移动主角 pos=(3,4) id=7") != std::string::npos);
+        REQUIRE(text.find("LOG   ERR   pos=(3,4) \"a message that is much longer than forty\"") != std::string::npos);
+        REQUIRE(text.find("MARK ") != std::string::npos);
+    }
+
+    SECTION("the ring keeps only the newest CAPACITY records") {
+        for (size_t i = 0; i < FlightRecorder::CAPACITY + 10; ++i) {
+            recorder.record(FlightRecorder::Kind::MOVE, static_cast<int>(EventType::MOVE),
+                            {1, 1}, -1, static_cast<int>(i));
+        }
+        fs::path file_path;
+        REQUIRE(recorder.dump(dir, file_path).status == 0);
+        REQUIRE(fs::file_size(file_path) ==
+                sizeof(FlightRecorder::FileHeader) + FlightRecorder::CAPACITY * sizeof(FlightRecorder::Record));
+
+        std::ifstream fin(file_path, std::ios::binary);
+        std::ostringstream out;
+        REQUIRE(FlightRecorder::decode(fin, out).status == 0);
+        REQUIRE(countRecordLines(out.str()) == FlightRecorder::CAPACITY);
+        // 最旧的 10 条被覆盖
+        REQUIRE(out.str().find("arg=9\n") == std::string::npos);
+        REQUIRE(out.str().find("arg=" + std::to_string(FlightRecorder::CAPACITY + 9)) != std::string::npos);
+    }
+
+    SECTION("decode rejects other files") {
+        std::istringstream in("definitely not a flight recorder dump");
+        std::ostringstream out;
+        REQUIRE(FlightRecorder::decode(in, out).status == -1);
+    }
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,78 @@
+#include "catch.hpp"
+#include "InputHandler.h"
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    // 用管道代替终端
+    struct Pipe {
+        int fds[2] = {-1, -1};
+        Pipe() { REQUIRE(pipe(fds) == 0); }
+        ~Pipe() {
+            close(fds[0]);
+            if (fds[1] >= 0) close(fds[1]);
+        }
+        void send(const std::string& bytes) {
+            REQUIRE(write(fds[1], bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+        }
+        void closeWriter() {
+            close(fds[1]);
+            fds[1] = -1;
+        }
+    };
+}
+
+TEST_CASE("InputHandler reads keys from a file descriptor", "[input]") {
+    Pipe keys;
+    InputHandler input(keys.fds[0]);
+
+    SECTION("keys are translated") {
+        keys.send("W\r\x7f_\x01q");
+        REQUIRE(input.waitKeyDown() == 'w');
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_ENTER);
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_BACKSPACE);
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_UNDERSCORE);
+        // 控制字符被忽略
+        REQUIRE(input.waitKeyDown() == 'q');
+    }
+
+    SECTION("arrow keys and a lone ESC") {
+        keys.send("\x1b[A\x1b[D");
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_UP);
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_LEFT);
+        keys.send("\x1b");
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_ESC);
+    }
+
+    SECTION("a timeout returns KEY_TIMEOUT") {
+        REQUIRE(input.waitKeyDown(10) == InputHandler::KEY_TIMEOUT);
+        keys.send("a");
+        REQUIRE(input.waitKeyDown(10) == 'a');
+    }
+
+    SECTION("pending keys are drained in one batch") {
+        keys.send("wwdd\r");
+        REQUIRE(input.waitKeyDown() == 'w');
+        std::vector<int> batch = input.drainKeys();
+        REQUIRE(batch == std::vector<int>{'w', 'd', 'd', InputHandler::KEY_ENTER});
+        REQUIRE(input.drainKeys().empty());
+        REQUIRE(input.waitKeyDown(10) == InputHandler::KEY_TIMEOUT);
+    }
+
+    SECTION("unread keys come back first and in order") {
+        keys.send("a");
+        input.unreadKeys({'s', InputHandler::KEY_ENTER});
+        REQUIRE(input.waitKeyDown() == 's');
+        REQUIRE(input.waitKeyDown() == InputHandler::KEY_ENTER);
+        REQUIRE(input.waitKeyDown() == 'a');
+    }
+
+    SECTION("closed input returns -1 instead of spinning") {
+        keys.closeWriter();
+        REQUIRE(input.waitKeyDown() == -1);
+        REQUIRE(input.waitKeyDown(10) == -1);
+    }
+}
+#endif
@@ -0,0 +1,36 @@
+#include "catch.hpp"
+#include "Log.h"
+#include <string>
+
+namespace {
+    int evaluations = 0;
+
+    std::string countedMessage() {
+        ++evaluations;
+        return "evaluated";
+    }
+}
+
+TEST_CASE("GAME_LOG only builds messages that will be logged", "[log]") {
+    // 测试使用默认的 INFO 等级
+    Controller::getInstance();
+    REQUIRE_FALSE(Controller::enabled(Controller::LogLevel::DEBUG));
+    REQUIRE(Controller::enabled(Controller::LogLevel::INFO));
+    REQUIRE(Controller::enabled(Controller::LogLevel::ERR));
+
+    evaluations = 0;
+    for (int i = 0; i < 100; ++i) {
+        GAME_LOG(DEBUG, countedMessage() + std::to_string(i));
+    }
+    REQUIRE(evaluations == 0);
+
+    GAME_LOG(WARN, countedMessage());
+    REQUIRE(evaluations == (Controller::compiledIn(Controller::LogLevel::WARN) ? 1 : 0));
+}
+
+TEST_CASE("Compile-time log levels are ordered", "[log]") {
+    STATIC_REQUIRE(Controller::compiledIn(Controller::LogLevel::ERR));
+    if (Controller::compiledIn(Controller::LogLevel::DEBUG)) {
+        REQUIRE(Controller::compiledIn(Controller::LogLevel::INFO));
+    }
+}
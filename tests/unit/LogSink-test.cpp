@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "LogSink.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    size_t countLines(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        std::string line;
+        size_t n = 0;
+        while (std::getline(file, line)) ++n;
+        return n;
+    }
+}
+
+TEST_CASE("LogSink routes records and loses nothing", "[log][sink]") {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "oucsurvsim-logsink-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    SECTION("records go to the files selected by targets") {
+        {
+            LogSink sink(dir);
+            sink.write(LogSink::DEBUG_LOG, "debug only");
+            sink.write(LogSink::DEBUG_LOG | LogSink::ERROR_LOG, "error");
+            sink.write(LogSink::DEBUG_LOG | LogSink::INFO_LOG, "info");
+            sink.flush();
+            REQUIRE(sink.writtenCount() == 3);
+        }
+        REQUIRE(countLines(dir / LogSink::DEBUG_FILE) == 3);
+        REQUIRE(countLines(dir / LogSink::ERROR_FILE) == 1);
+        REQUIRE(countLines(dir / LogSink::INFO_FILE) == 1);
+        REQUIRE(countLines(dir / LogSink::WARN_FILE) == 0);
+    }
+
+    SECTION("a tiny queue under several producers keeps every record") {
+        constexpr int PRODUCERS = 4, PER_PRODUCER = 5000;
+        {
+            LogSink sink(dir, 8);
+            std::vector<std::thread> producers;
+            for (int t = 0; t < PRODUCERS; ++t) {
+                producers.emplace_back([&sink, t] {
+                    for (int i = 0; i < PER_PRODUCER; ++i) {
+                        sink.write(LogSink::DEBUG_LOG, std::to_string(t) + ":" + std::to_string(i));
+                    }
+                });
+            }
+            for (auto& producer : producers) producer.join();
+            sink.flush();
+            REQUIRE(sink.writtenCount() == PRODUCERS * PER_PRODUCER);
+            // 批量写入，写文件的次数远小于记录数
+            REQUIRE(sink.batchCount() < sink.writtenCount());
+        }
+        REQUIRE(countLines(dir / LogSink::DEBUG_FILE) == PRODUCERS * PER_PRODUCER);
+    }
+
+    fs::remove_all(dir);
+}
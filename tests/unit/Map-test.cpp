@@ -2,7 +2,8 @@
  * @brief Map 类的测试代码
  * @details Version 1 的 Map 类可以通过测试，在编写 Controller 类进行最后阶段\n
  *          的统筹时,由于进行了破坏性的重构，本测试模块废弃，但可以保证重构的\n
- *          代码不影响 Map 的正常运行
+ *          代码不影响 Map 的正常运行\n
+ *          文件末尾是重构之后的碰撞检测测试
  */
 // #include "catch.hpp"
 // #include "Map.h"
@@ -468,3 +469,553 @@
 // //     const auto path = Map::BASE_DIR + TMP_FILE;
 // //     std::filesystem::remove(path);
 // // }
+
+#include "catch.hpp"
+#include "Controller.h"
+#include "Map.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 写入 maps/ 目录下的临时地图，析构时删除
+    struct TempMap {
+        std::filesystem::path path;
+        TempMap(const std::string& name, const std::vector<std::string>& rows) :
+            path(Controller::getInstance()->getRootDir() / "maps" / name) {
+            std::ofstream file(path);
+            for (size_t i = 0; i < rows.size(); ++i)
+                file << rows[i] << (i + 1 < rows.size() ? "\n" : "");
+        }
+        ~TempMap() {
+            std::filesystem::remove(path);
+            std::filesystem::remove(std::filesystem::path(path).replace_extension(".bin"));
+        }
+    };
+}
+
+TEST_CASE("Collision grid keeps the scanner's move semantics", "[Map][move]") {
+    TempMap file("collision_test.txt", {
+        "##########o   ###",
+        "#               #",
+        "#  9         1  #",
+        "o               #",
+        "                #",
+        "##########i   ###"
+    });
+    Map map("collision_test.txt");
+    REQUIRE(map.valid());
+    REQUIRE(map.getPos() == Position(2, 13));
+    EventType event = EventType::NONE;
+    int id = -1;
+
+    SECTION("walls and narrow gaps block the move") {
+        REQUIRE(map.moveProtagonist(1, event, id).status == 0);
+        REQUIRE(map.moveProtagonist(1, event, id).status == 1);
+        REQUIRE(map.getPos() == Position(2, 14));
+        // 出口最右侧的一格放不下主角
+        REQUIRE(map.moveProtagonist(0, event, id).status == 0);
+        REQUIRE(map.moveProtagonist(0, event, id).status == 1);
+        REQUIRE(map.getPos() == Position(1, 14));
+    }
+
+    SECTION("a wide NPC is hit from either of its columns") {
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(map.moveProtagonist(3, event, id).status == 0);
+        REQUIRE(map.getPos() == Position(2, 5));
+        map.moveProtagonist(3, event, id);
+        REQUIRE(event == EventType::AC_INST);
+        REQUIRE(id == '9');
+        REQUIRE(map.getPos() == Position(2, 5));
+    }
+
+    SECTION("exits are entered in the direction they face") {
+        map.moveProtagonist(3, event, id);
+        map.moveProtagonist(0, event, id);
+        map.moveProtagonist(0, event, id);
+        REQUIRE(event == EventType::JUMP);
+        REQUIRE(id == 0);
+        REQUIRE(map.getPos() == Position(1, 12));
+
+        map.moveProtagonist(2, event, id);
+        map.moveProtagonist(2, event, id);
+        while (map.getPos().y > 1)
+            REQUIRE(map.moveProtagonist(3, event, id).status == 0);
+        map.moveProtagonist(3, event, id);
+        REQUIRE(event == EventType::JUMP);
+        REQUIRE(id == 1);
+        REQUIRE(map.getPos() == Position(3, 1));
+    }
+}
+
+TEST_CASE("Collision grid matches the scanner on every shipped map", "[Map][move]") {
+    for (const auto& entry : std::filesystem::directory_iterator(Controller::getInstance()->getRootDir() / "maps")) {
+        if (entry.path().extension() != ".txt")
+            continue;
+        Map map(entry.path().filename().string());
+        if (!map.valid())
+            continue;
+        INFO(entry.path().filename().string());
+        int row = map.getPos().x;
+        for (int i = 0; i < map.getMaxHeight(); ++i) {
+            for (int j = 0; j + 1 < map.getMaxWidth(); ++j) {
+                if (map.detectCollision({i, j}) != map.scanCollision({i, j}, i != row))
+                    FAIL("mismatch at " << i << "," << j);
+            }
+        }
+    }
+}
+
+TEST_CASE("Spatial index answers position and radius queries", "[Map][entity]") {
+    TempMap file("entity_test.txt", {
+        "##########o   ###",
+        "#               #",
+        "#  9         1  #",
+        "o               #",
+        "                #",
+        "##########i   ###"
+    });
+    Map map("entity_test.txt");
+    REQUIRE(map.valid());
+    REQUIRE(map.getEntities().size() == 4);
+
+    SECTION("every cell of an entity maps back to it") {
+        const Map::Entity* exit = map.entityAt({0, 13});
+        REQUIRE(exit != nullptr);
+        REQUIRE(exit->type == Map::EntityType::EXIT);
+        REQUIRE(exit->id == 0);
+        REQUIRE(exit->width == 4);
+
+        const Map::Entity* npc = map.entityAt({2, 4});
+        REQUIRE(npc != nullptr);
+        REQUIRE(npc->type == Map::EntityType::NPC);
+        REQUIRE(npc->code == '9');
+        REQUIRE(npc->pos == Position(2, 3));
+
+        const Map::Entity* side_exit = map.entityAt({4, 0});
+        REQUIRE(side_exit != nullptr);
+        REQUIRE(side_exit->type == Map::EntityType::EXIT);
+        REQUIRE(side_exit->id == 1);
+        REQUIRE(side_exit->height == 2);
+
+        const Map::Entity* entry = map.entityAt({5, 11});
+        REQUIRE(entry != nullptr);
+        REQUIRE(entry->type == Map::EntityType::ENTRY);
+
+        REQUIRE(map.entityAt({2, 5}) == nullptr);
+        REQUIRE(map.entityAt({2, 13}) == nullptr);
+        REQUIRE(map.entityAt({-1, 0}) == nullptr);
+    }
+
+    SECTION("radius queries return each entity once") {
+        auto near_npc = map.entitiesWithin({2, 6}, 2);
+        REQUIRE(near_npc.size() == 1);
+        REQUIRE(near_npc[0].type == Map::EntityType::NPC);
+
+        auto corner = map.entitiesWithin({2, 1}, 2);
+        REQUIRE(corner.size() == 2);
+        REQUIRE(corner[0].type == Map::EntityType::NPC);
+        REQUIRE(corner[1].type == Map::EntityType::EXIT);
+
+        REQUIRE(map.entitiesWithin({2, 13}, 20).size() == 4);
+        REQUIRE(map.entitiesWithin({2, 13}, 0).empty());
+        REQUIRE(map.entitiesWithin({2, 13}, -1).empty());
+    }
+}
+
+TEST_CASE("Sessions share one read-only terrain", "[Map][terrain]") {
+    TempMap file("terrain_test.txt", {
+        "##########o   ###",
+        "#               #",
+        "#  9         1  #",
+        "o               #",
+        "                #",
+        "##########i   ###"
+    });
+    Map first("terrain_test.txt");
+    REQUIRE(first.valid());
+    auto terrain = first.getTerrain();
+    REQUIRE(terrain != nullptr);
+    Map second(terrain, {1, 5});
+    REQUIRE(second.valid());
+    REQUIRE(second.getTerrain() == terrain);
+    REQUIRE(second.getRevision() == first.getRevision());
+    REQUIRE(second.getPos() == Position(1, 5));
+    REQUIRE(Map(terrain).getPos() == first.getPos());
+
+    // 地形中不包含主角，两个会话各自移动
+    EventType event = EventType::NONE;
+    int id = -1;
+    REQUIRE(first.moveProtagonist(3, event, id).status == 0);
+    REQUIRE(second.moveProtagonist(1, event, id).status == 0);
+    REQUIRE(first.getPos() == Position(2, 12));
+    REQUIRE(second.getPos() == Position(1, 6));
+    int protagonists = 0;
+    for (int i = 0; i < Map::MAX_HEIGHT; ++i)
+        for (int j = 0; j < Map::MAX_WIDTH; ++j)
+            protagonists += terrain->map[i][j] == '1';
+    REQUIRE(protagonists == 0);
+    REQUIRE(first.getRevision() == second.getRevision());
+    REQUIRE(second.entityAt({2, 3}) == first.entityAt({2, 3}));
+
+    // 每个会话只保存自己的状态
+    REQUIRE(sizeof(Map) * 100 < sizeof(Map::Terrain));
+    REQUIRE(Map().getTerrain() == nullptr);
+    REQUIRE_FALSE(Map(std::shared_ptr<const Map::Terrain>()).valid());
+}
+
+TEST_CASE("Routes walk to exits and NPCs along the collision grid", "[Map][goto]") {
+    TempMap file("route_test.txt", {
+        "##########o   ###",
+        "#     #         #",
+        "#  9  #      1  #",
+        "o     #         #",
+        "      ####  ### #",
+        "#               #",
+        "##########i   ###"
+    });
+    Map map("route_test.txt");
+    REQUIRE(map.valid());
+    const Position spawn = map.getPos();
+    // 按路线移动，除最后一步外都是普通移动，返回最后一步的事件
+    auto walk = [&map](const std::vector<int>& directions, int& id) {
+        EventType event = EventType::NONE;
+        for (size_t i = 0; i < directions.size(); ++i) {
+            Position before = map.getPos();
+            map.moveProtagonist(directions[i], event, id);
+            if (i + 1 < directions.size() && (event != EventType::NONE || map.getPos() == before))
+                return EventType::QUIT;
+        }
+        return event;
+    };
+
+    std::vector<int> directions;
+    int id = -1;
+    SECTION("the top exit is one step up") {
+        map.placeProtagonist({1, 11});
+        REQUIRE(map.goTo(0, 2, directions).status == 0);
+        REQUIRE(directions == std::vector<int>{0});
+        REQUIRE(walk(directions, id) == EventType::JUMP);
+        REQUIRE(id == 0);
+    }
+
+    SECTION("the NPC is reached around the wall") {
+        REQUIRE(map.goTo(0, 0, directions).status == 0);
+        REQUIRE(walk(directions, id) == EventType::AC_INST);
+        REQUIRE(id == '9');
+        // 绕过中间的墙至少要走到第 5 行
+        REQUIRE(directions.size() > static_cast<size_t>(spawn.y - 3));
+    }
+
+    SECTION("the side exit ends with a step to the left") {
+        REQUIRE(map.goTo(1, 2, directions).status == 0);
+        REQUIRE(directions.back() == 3);
+        REQUIRE(walk(directions, id) == EventType::JUMP);
+        REQUIRE(id == 1);
+    }
+
+    SECTION("unknown targets are rejected") {
+        REQUIRE(map.goTo(5, 2, directions).status == -1);
+        REQUIRE(map.goTo(0, 3, directions).status == -1);
+        REQUIRE(directions.empty());
+        REQUIRE(map.getPos() == spawn);
+    }
+
+    SECTION("distance fields are built once and shared") {
+        auto terrain = map.getTerrain();
+        auto first = terrain->distanceTo(0);
+        REQUIRE(terrain->distanceTo(0) == first);
+        Map other(terrain);
+        REQUIRE(other.goTo(0, 0, directions).status == 0);
+        REQUIRE(terrain->distanceTo(0) == first);
+    }
+}
+
+TEST_CASE("Every reachable exit of a shipped map can be walked to", "[Map][goto]") {
+    for (const auto& entry : std::filesystem::directory_iterator(Controller::getInstance()->getRootDir() / "maps")) {
+        if (entry.path().extension() != ".txt")
+            continue;
+        Map map(entry.path().filename().string());
+        if (!map.valid())
+            continue;
+        INFO(entry.path().filename().string());
+        const Position spawn = map.getPos();
+        int routes = 0;
+        for (const auto& exit : map.getEntities()) {
+            if (exit.type != Map::EntityType::EXIT)
+                continue;
+            std::vector<int> directions;
+            map.placeProtagonist();
+            if (map.goTo(exit.id, 2, directions).status)
+                continue;
+            ++routes;
+            EventType event = EventType::NONE;
+            int id = -1;
+            for (const auto& direction : directions)
+                map.moveProtagonist(direction, event, id);
+            CHECK(event == EventType::JUMP);
+            CHECK(id == exit.id);
+        }
+        // 出生点至少能走到一个出口
+        CHECK((routes > 0 || map.getEntities().empty()));
+        map.placeProtagonist(spawn);
+    }
+}
+
+TEST_CASE("Compiled maps load the same state as the text file", "[Map][compiled]") {
+    std::vector<std::string> rows = {
+        "##########o   ###",
+        "#               #",
+        "#  9         1  #",
+        "o               #",
+        "                #",
+        "##########i   ###"
+    };
+    TempMap file("compiled_test.txt", rows);
+    Map text("compiled_test.txt");
+    REQUIRE(text.valid());
+    REQUIRE_FALSE(text.isCompiled());
+
+    size_t bytes = 0;
+    REQUIRE(Map::compile("compiled_test.txt", bytes).status == 0);
+    REQUIRE(bytes > 0);
+    REQUIRE(std::filesystem::file_size(std::filesystem::path(file.path).replace_extension(".bin")) == bytes);
+
+    SECTION("the compiled file restores the map, collisions and entities") {
+        Map compiled("compiled_test.txt");
+        REQUIRE(compiled.valid());
+        REQUIRE(compiled.isCompiled());
+        REQUIRE(compiled.getPos() == text.getPos());
+        REQUIRE(compiled.getMaxWidth() == text.getMaxWidth());
+        REQUIRE(compiled.getMaxHeight() == text.getMaxHeight());
+        REQUIRE(compiled.getEntities().size() == text.getEntities().size());
+        for (size_t i = 0; i < text.getEntities().size(); ++i) {
+            const auto& expected = text.getEntities()[i];
+            const auto& actual = compiled.getEntities()[i];
+            REQUIRE(actual.type == expected.type);
+            REQUIRE(actual.id == expected.id);
+            REQUIRE(actual.code == expected.code);
+            REQUIRE(actual.pos == expected.pos);
+        }
+        int row = text.getPos().x;
+        for (int i = 0; i < text.getMaxHeight(); ++i) {
+            for (int j = 0; j + 1 < text.getMaxWidth(); ++j) {
+                if (compiled.detectCollision({i, j}) != text.detectCollision({i, j}) ||
+                    compiled.scanCollision({i, j}, i != row) != text.scanCollision({i, j}, i != row))
+                    FAIL("mismatch at " << i << "," << j);
+            }
+        }
+
+        // 从二进制文件加载的地图照常移动和触发事件
+        EventType event = EventType::NONE;
+        int id = -1;
+        REQUIRE(compiled.moveProtagonist(3, event, id).status == 0);
+        REQUIRE(compiled.moveProtagonist(0, event, id).status == 0);
+        REQUIRE(compiled.moveProtagonist(0, event, id).status == 0);
+        REQUIRE(event == EventType::JUMP);
+        REQUIRE(id == 0);
+    }
+
+    SECTION("a changed text file is loaded instead of the stale binary") {
+        rows.insert(rows.begin() + 1, "#               #");
+        TempMap changed("compiled_test.txt", rows);
+        Map map("compiled_test.txt");
+        REQUIRE(map.valid());
+        REQUIRE_FALSE(map.isCompiled());
+        REQUIRE(map.getMaxHeight() == text.getMaxHeight() + 1);
+    }
+
+    SECTION("a binary with out-of-range indices is ignored") {
+        // 文件头之后依次为 rows 行的地图字符、碰撞网格、实体索引；碰撞网格每格依次为
+        // tile、vertical_exit、horizontal_exit、exit_id
+        const auto bin = std::filesystem::path(file.path).replace_extension(".bin");
+        std::fstream out(bin, std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t cell_size = 0, rows_saved = 0;
+        out.seekg(20);
+        out.read(reinterpret_cast<char*>(&cell_size), sizeof(cell_size));
+        out.seekg(56);
+        out.read(reinterpret_cast<char*>(&rows_saved), sizeof(rows_saved));
+        const std::streamoff cells = static_cast<std::streamoff>(rows_saved) * Map::MAX_WIDTH;
+        const std::streamoff grid = 80 + cells, index = grid + cells * cell_size;
+        SECTION("entity index") {
+            const int16_t slot = 1000;
+            out.seekp(index);
+            out.write(reinterpret_cast<const char*>(&slot), sizeof(slot));
+        }
+        SECTION("exit id") {
+            const int8_t exit_id = 100;
+            out.seekp(grid + 3);
+            out.write(reinterpret_cast<const char*>(&exit_id), sizeof(exit_id));
+        }
+        SECTION("collision tile") {
+            const char tile = '#';
+            out.seekp(grid);
+            out.write(&tile, sizeof(tile));
+        }
+        out.close();
+        Map map("compiled_test.txt");
+        REQUIRE(map.valid());
+        REQUIRE_FALSE(map.isCompiled());
+        REQUIRE(map.getEntities().size() == text.getEntities().size());
+    }
+
+    SECTION("a binary from an older format version is ignored") {
+        // 版本 1 的地形中可能留有主角的 '1'
+        const auto bin = std::filesystem::path(file.path).replace_extension(".bin");
+        std::fstream out(bin, std::ios::in | std::ios::out | std::ios::binary);
+        const uint32_t old_version = 1;
+        out.seekp(8);
+        out.write(reinterpret_cast<const char*>(&old_version), sizeof(old_version));
+        out.close();
+        Map map("compiled_test.txt");
+        REQUIRE(map.valid());
+        REQUIRE_FALSE(map.isCompiled());
+    }
+
+    SECTION("compiled maps can be turned off") {
+        Map::useCompiled(false);
+        Map map("compiled_test.txt");
+        Map::useCompiled(true);
+        REQUIRE(map.valid());
+        REQUIRE_FALSE(map.isCompiled());
+    }
+}
+
+TEST_CASE("Map validator accepts every shipped map", "[Map][validate]") {
+    for (const auto& entry : std::filesystem::directory_iterator(Controller::getInstance()->getRootDir() / "maps")) {
+        if (entry.path().extension() != ".txt")
+            continue;
+        Map::useCompiled(false);
+        Map map(entry.path().filename().string());
+        Map::useCompiled(true);
+        INFO(entry.path().filename().string() << ": " << map.getValidMsg());
+        REQUIRE(map.valid());
+    }
+}
+
+TEST_CASE("Map validator reports where a map is broken", "[Map][validate]") {
+    std::vector<std::string> rows = {
+        "##########o   ###",
+        "#               #",
+        "#  9         1  #",
+        "o               #",
+        "                #",
+        "##########i   ###"
+    };
+    auto check = [](const std::vector<std::string>& rows, const std::string& expected) {
+        TempMap file("validate_test.txt", rows);
+        Map map("validate_test.txt");
+        INFO(map.getValidMsg());
+        REQUIRE_FALSE(map.valid());
+        REQUIRE(map.getValidMsg().find(expected) != std::string::npos);
+    };
+
+    SECTION("the original map is valid") {
+        TempMap file("validate_test.txt", rows);
+        REQUIRE(Map("validate_test.txt").valid());
+    }
+
+    SECTION("a gap in the wall") {
+        rows[1][16] = ' ';
+        check(rows, "地图未封闭：第 2 行第 17 列");
+    }
+
+    SECTION("an exit that is not 4 wide") {
+        rows[0] = "##########o  ####";
+        check(rows, "第 1 行第 11 列");
+    }
+
+    SECTION("a wide glyph against a wall") {
+        rows[2] = "#  9          1#";
+        rows[2] += "#";
+        check(rows, "宽字符右侧必须留出一格空地：第 3 行第 15 列");
+    }
+
+    SECTION("a map without a spawn point") {
+        rows[2] = "#  9            #";
+        check(rows, "没有主角的出生点");
+    }
+
+    SECTION("an exit that cannot be reached") {
+        rows[1] = "#########       #";
+        rows[2] = "#  9    #     1 #";
+        rows[3] = "o       #       #";
+        rows[4] = "        #       #";
+        check(rows, "出入口无法从出生点到达：第 4 行第 1 列");
+    }
+}
+
+TEST_CASE("Maps can be validated on several threads at once", "[Map][validate]") {
+    std::vector<std::string> names;
+    for (const auto& entry : std::filesystem::directory_iterator(Controller::getInstance()->getRootDir() / "maps"))
+        if (entry.path().extension() == ".txt")
+            names.push_back(entry.path().filename().string());
+    REQUIRE_FALSE(names.empty());
+
+    Map::useCompiled(false);
+    std::vector<std::thread> threads;
+    std::atomic<int> failures {0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&names, &failures]() {
+            for (int round = 0; round < 10; ++round)
+                for (const auto& name : names)
+                    if (!Map(name).valid())
+                        ++failures;
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    Map::useCompiled(true);
+    REQUIRE(failures == 0);
+}
+
+TEST_CASE("Map lint reports file positions for maps outside maps/", "[Map][validate]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "oucsurvsim-lint-test";
+    fs::create_directories(dir);
+    auto write = [&dir](const std::string& name, const std::string& text) {
+        std::ofstream(dir / name) << text;
+        return dir / name;
+    };
+    const std::string body =
+        "##########o   ###\n"
+        "#               #\n"
+        "#  9         1  #\n"
+        "o               #\n"
+        "                #\n"
+        "##########i   ###";
+    Position where;
+
+    SECTION("a valid map") {
+        REQUIRE(Map::lint(write("good.txt", body), where).status == 0);
+        REQUIRE(where == Position(-1, -1));
+        REQUIRE_FALSE(fs::exists(dir / "good.bin"));
+        REQUIRE(Map::lint(dir / "good.txt", where, true).status == 0);
+        REQUIRE(fs::exists(dir / "good.bin"));
+    }
+
+    SECTION("leading blank lines count towards the line number") {
+        std::string broken = body;
+        broken[18 + 16] = ' ';
+        Message msg = Map::lint(write("gap.txt", "\n\n" + broken), where);
+        REQUIRE(msg.status == -1);
+        REQUIRE(where == Position(4, 17));
+        REQUIRE(msg.msg.find("第 4 行第 17 列") != std::string::npos);
+    }
+
+    SECTION("an illegal character") {
+        std::string broken = body;
+        broken[18 * 2 + 5] = '*';
+        REQUIRE(Map::lint(write("char.txt", broken), where).status == -1);
+        REQUIRE(where == Position(3, 6));
+    }
+
+    SECTION("a missing file") {
+        REQUIRE(Map::lint(dir / "missing.txt", where).status == -1);
+        REQUIRE(where == Position(-1, -1));
+    }
+    fs::remove_all(dir);
+}
@@ -0,0 +1,49 @@
+#include "catch.hpp"
+#include "OutputWriter.h"
+#include <sstream>
+#include <string>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <unistd.h>
+
+TEST_CASE("OutputWriter writes each frame with one write", "[output]") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    OutputWriter writer(fds[1]);
+
+    writer.append("\x1b[1;1H");
+    writer.buffer() += "hello";
+    REQUIRE(writer.flush().status == 0);
+    REQUIRE(writer.buffer().empty());
+
+    char bytes[64] = {};
+    REQUIRE(read(fds[0], bytes, sizeof(bytes)) == 11);
+    REQUIRE(std::string(bytes, 11) == "\x1b[1;1Hhello");
+
+    const auto& stats = writer.getStats();
+    REQUIRE(stats.frames == 1);
+    REQUIRE(stats.bytes == 11);
+    REQUIRE(stats.syscalls == 1);
+    REQUIRE(stats.frame_syscalls == 1);
+
+    // 空帧不输出
+    REQUIRE(writer.flush().status == 1);
+    REQUIRE(stats.frames == 1);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
+
+TEST_CASE("OutputWriter can write to a stream", "[output]") {
+    std::ostringstream out;
+    OutputWriter writer;
+    writer.setStream(&out);
+    writer.append("ab");
+    REQUIRE(writer.flush().status == 0);
+    writer.append("cde");
+    REQUIRE(writer.flush().status == 0);
+    REQUIRE(out.str() == "abcde");
+    REQUIRE(writer.getStats().frames == 2);
+    REQUIRE(writer.getStats().frame_bytes == 3);
+    REQUIRE(writer.getStats().max_frame_bytes == 3);
+}
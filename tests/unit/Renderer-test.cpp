@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "Controller.h"
+#include "Map.h"
+#include "ReplayInput.h"
+#include "Renderer.h"
+#include "View.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+TEST_CASE("Headless View keeps pane contents without output", "[view][renderer]") {
+    auto controller = Controller::getInstance();
+    auto old_map = controller->map;
+    controller->map = std::make_shared<Map>("Center.txt");
+    REQUIRE(controller->map->valid());
+    auto view = View::getInstance();
+    auto old_renderer = view->getRenderer();
+    auto headless = std::make_shared<NullRenderer>(220, 70);
+
+    // 无界面后端不应向标准输出写任何内容
+    OutputCapture capture;
+    auto old_buf = std::cout.rdbuf(&capture);
+    view->setRenderer(headless);
+    view->setFixedSize(0, 0);
+    view->clearOutputs();
+    bool drawn = view->reDraw(true);
+    view->present();
+    uint64_t frames = headless->getFrames();
+
+    for (int i = 0; i < 200; ++i)
+        view->printLog("log " + std::to_string(i), "green");
+    view->printQuestion("体育老师", "要去锻炼吗？", "yellow");
+    view->printCmd("move");
+
+    Position start = controller->map->getPos();
+    Position next {start.x, start.y == 0 ? 1 : start.y - 1};
+    Message moved = view->drawPoMove(start, next);
+    uint64_t before_present = headless->getFrames();
+    view->present();
+    // 没有新的内容时不输出
+    view->present();
+    std::cout.rdbuf(old_buf);
+
+    REQUIRE(drawn);
+    REQUIRE(frames == 1);
+    REQUIRE(capture.bytes() == 0);
+    // 所有日志、问题、命令和移动合并成一帧
+    REQUIRE(before_present == frames);
+    REQUIRE(headless->getFrames() == frames + 1);
+
+    // 日志只保留能显示的行数，最新的一行在最后
+    const auto& logs = view->getLogs();
+    REQUIRE(logs.size() > 0);
+    REQUIRE(logs.size() < 200);
+    REQUIRE(logs.back().text == "log 199");
+    REQUIRE(logs.front().text == "log " + std::to_string(200 - logs.size()));
+    REQUIRE(view->getGameOutputs().size() == 1);
+    REQUIRE(view->getGameOutputs().back().text == "体育老师: 要去锻炼吗？");
+
+    REQUIRE(moved.status == 0);
+    REQUIRE(view->getProtagonistPos() == next);
+
+    view->clearOutputs();
+    view->setRenderer(old_renderer);
+    controller->map = old_map;
+}
+
+TEST_CASE("View writes one terminal frame per present", "[view][renderer]") {
+    auto controller = Controller::getInstance();
+    auto old_map = controller->map;
+    controller->map = std::make_shared<Map>("Center.txt");
+    REQUIRE(controller->map->valid());
+    auto view = View::getInstance();
+    auto old_renderer = view->getRenderer();
+
+    OutputCapture capture;
+    std::ostream null_out(&capture);
+    auto terminal = std::make_shared<TerminalRenderer>();
+    terminal->getWriter().setStream(&null_out);
+    view->setRenderer(terminal);
+    view->setFixedSize(220, 70);
+    view->clearOutputs();
+    REQUIRE(view->reDraw());
+    view->present();
+    const auto& stats = terminal->getWriter().getStats();
+    REQUIRE(stats.frames == 1);
+
+    // 与 NPC 对话时一个节点的输出
+    view->printQuestion("体育老师", "今天的体育课要跑八百米。", "yellow");
+    view->printQuestion("体育老师", "跑完可以获得体力。", "yellow");
+    view->printQuestion("", "请选择：", "", Rgb(255, 255, 0));
+    view->printOptions({"1. 跑步", "2. 离开"});
+    REQUIRE(stats.frames == 1);
+    view->present();
+    REQUIRE(stats.frames == 2);
+    REQUIRE(view->getGameOutputs().size() == 5);
+
+    terminal->getWriter().setStream(nullptr);
+    view->clearOutputs();
+    view->setRenderer(old_renderer);
+    controller->map = old_map;
+}
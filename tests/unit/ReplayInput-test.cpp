@@ -0,0 +1,62 @@
+#include "catch.hpp"
+#include "ReplayInput.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("ReplayInput replays a script", "[input][replay]") {
+    std::istringstream script(
+        "# comment\n"
+        "login alice\n"
+        "cmd Move\n"
+        "type wd\n"
+        "key esc\n"
+        "sleep 5\n"
+        "key enter\n");
+    ReplayInput replay(script);
+    REQUIRE(replay.valid());
+    REQUIRE(replay.stepCount() == 4);
+
+    std::string name;
+    REQUIRE(replay.readLine(name));
+    REQUIRE(name == "alice");
+    REQUIRE_FALSE(replay.readLine(name));
+
+    SECTION("keys come out in order and the script then closes") {
+        std::vector<int> keys;
+        for (int key = replay.waitKeyDown(); key != -1; key = replay.waitKeyDown())
+            keys.push_back(key);
+        REQUIRE(keys == std::vector<int>{'m', 'o', 'v', 'e', InputSource::KEY_ENTER,
+                                         'w', 'd', InputSource::KEY_ESC, InputSource::KEY_ENTER});
+        REQUIRE(replay.finished());
+        std::ostringstream out;
+        REQUIRE(replay.report(out).status == 0);
+        REQUIRE(out.str().find("cmd Move") != std::string::npos);
+    }
+
+    SECTION("the next step only arrives once the game blocks") {
+        REQUIRE(replay.waitKeyDown() == 'm');
+        REQUIRE(replay.drainKeys() == std::vector<int>{'o', 'v', 'e', InputSource::KEY_ENTER});
+        REQUIRE(replay.waitKeyDown(0) == InputSource::KEY_TIMEOUT);
+        REQUIRE(replay.waitKeyDown() == 'w');
+        REQUIRE(replay.drainKeys() == std::vector<int>{'d'});
+        REQUIRE(replay.waitKeyDown() == InputSource::KEY_ESC);
+        // sleep 5：超时比等待时间短时返回 KEY_TIMEOUT
+        REQUIRE(replay.waitKeyDown(1) == InputSource::KEY_TIMEOUT);
+        REQUIRE(replay.waitKeyDown() == InputSource::KEY_ENTER);
+        REQUIRE(replay.waitKeyDown() == -1);
+    }
+
+    SECTION("stopping early is reported") {
+        REQUIRE(replay.waitKeyDown() == 'm');
+        std::ostringstream out;
+        REQUIRE(replay.report(out).status == 1);
+    }
+}
+
+TEST_CASE("ReplayInput rejects bad scripts with a line number", "[input][replay]") {
+    std::istringstream script("cmd help\nkey nosuchkey\n");
+    ReplayInput replay(script);
+    REQUIRE_FALSE(replay.valid());
+    REQUIRE(replay.getValidMsg().find("第 2 行") != std::string::npos);
+}
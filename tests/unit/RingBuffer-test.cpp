@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "RingBuffer.h"
+#include <string>
+
+TEST_CASE("RingBuffer overwrites the oldest element when full", "[ring]") {
+    RingBuffer<int> ring(3);
+    REQUIRE(ring.empty());
+    REQUIRE(ring.capacity() == 3);
+
+    for (int i = 1; i <= 3; ++i)
+        ring.pushBack() = i;
+    REQUIRE(ring.full());
+    REQUIRE(ring.front() == 1);
+    REQUIRE(ring.back() == 3);
+
+    ring.pushBack() = 4;
+    ring.pushBack() = 5;
+    REQUIRE(ring.size() == 3);
+    REQUIRE(ring[0] == 3);
+    REQUIRE(ring[1] == 4);
+    REQUIRE(ring[2] == 5);
+
+    SECTION("shrinking keeps the newest elements") {
+        ring.setCapacity(2);
+        REQUIRE(ring.size() == 2);
+        REQUIRE(ring.front() == 4);
+        REQUIRE(ring.back() == 5);
+    }
+
+    SECTION("growing keeps every element in order") {
+        ring.setCapacity(5);
+        REQUIRE(ring.size() == 3);
+        ring.pushBack() = 6;
+        REQUIRE(ring[0] == 3);
+        REQUIRE(ring.back() == 6);
+        REQUIRE_FALSE(ring.full());
+    }
+
+    SECTION("clear keeps the capacity") {
+        ring.clear();
+        REQUIRE(ring.empty());
+        REQUIRE(ring.capacity() == 3);
+        ring.pushBack() = 7;
+        REQUIRE(ring.front() == 7);
+    }
+}
+
+TEST_CASE("RingBuffer hands back the overwritten slot for reuse", "[ring]") {
+    RingBuffer<std::string> ring(2);
+    ring.pushBack() = std::string(100, 'a');
+    ring.pushBack() = std::string(100, 'b');
+    const char* storage = ring.front().data();
+
+    // 第三个元素写入最旧的槽位，其中的字符串内存可以直接复用
+    std::string& slot = ring.pushBack();
+    REQUIRE(slot == std::string(100, 'a'));
+    slot.assign("short line");
+    REQUIRE(slot.data() == storage);
+    REQUIRE(ring.front() == std::string(100, 'b'));
+    REQUIRE(ring.back() == "short line");
+}
@@ -0,0 +1,163 @@
+#include "catch.hpp"
+#include "Screen.h"
+#include <string>
+
+namespace {
+    std::string glyphAt(const Screen& screen, const int& x, const int& y) {
+        const auto& cell = screen.at(x, y);
+        return std::string(cell.glyph, cell.length);
+    }
+}
+
+TEST_CASE("Screen writes glyphs into cells", "[screen]") {
+    Screen screen;
+    screen.resize(10, 3);
+
+    SECTION("wide glyphs take two cells") {
+        REQUIRE(screen.put(1, 1, "a中b") == 5);
+        REQUIRE(glyphAt(screen, 1, 1) == "a");
+        REQUIRE(glyphAt(screen, 1, 2) == "中");
+        REQUIRE(screen.at(1, 2).width == 2);
+        REQUIRE(screen.at(1, 3).width == 0);
+        REQUIRE(glyphAt(screen, 1, 4) == "b");
+    }
+
+    SECTION("box drawing and private use glyphs take one cell") {
+        REQUIRE(screen.put(1, 1, "\U00002502\U000f1302") == 3);
+    }
+
+    SECTION("text is cut at the limit and a wide glyph that does not fit is padded") {
+        REQUIRE(screen.put(2, 1, "abc中", StyleTable::DEFAULT_STYLE, 4) == 5);
+        REQUIRE(glyphAt(screen, 2, 4) == " ");
+        screen.put(3, 8, "abcdef");
+        REQUIRE(glyphAt(screen, 3, 10) == "c");
+    }
+
+    SECTION("overwriting half of a wide glyph clears the other half") {
+        screen.put(1, 1, "中文");
+        screen.put(1, 2, "x");
+        REQUIRE(glyphAt(screen, 1, 1) == " ");
+        REQUIRE(glyphAt(screen, 1, 2) == "x");
+        REQUIRE(screen.at(1, 3).width == 2);
+        screen.put(1, 3, "y");
+        REQUIRE(glyphAt(screen, 1, 4) == " ");
+        REQUIRE(screen.at(1, 4).width == 1);
+    }
+}
+
+TEST_CASE("Screen only outputs cells that changed", "[screen]") {
+    Screen screen;
+    screen.resize(20, 4);
+    TextStyle style;
+    style.fg = TextStyle::ansi(1);
+    style.bold = true;
+    StyleId red = StyleTable::getInstance().intern(style);
+    screen.put(2, 3, "hello", red);
+    screen.setCursor(4, 1);
+
+    std::string out;
+    REQUIRE(screen.present(out) == 5);
+    REQUIRE(out.rfind("\x1b[0m\x1b[2J", 0) == 0);
+    REQUIRE(out.find("\x1b[2;3H\x1b[0;1;31mhello\x1b[0m\x1b[4;1H") != std::string::npos);
+
+    SECTION("an unchanged frame outputs nothing") {
+        out.clear();
+        screen.clear();
+        screen.put(2, 3, "hello", red);
+        REQUIRE(screen.present(out) == 0);
+        REQUIRE(out.empty());
+    }
+
+    SECTION("a changed cell outputs only itself") {
+        out.clear();
+        screen.put(2, 4, "a", red);
+        REQUIRE(screen.present(out) == 1);
+        REQUIRE(out == "\x1b[2;4H\x1b[0;1;31ma\x1b[0m\x1b[4;1H");
+    }
+
+    SECTION("erased cells are overwritten with blanks") {
+        out.clear();
+        screen.fill(2, 3, 5);
+        REQUIRE(screen.present(out) == 5);
+        REQUIRE(out == "\x1b[2;3H\x1b[0m     \x1b[4;1H");
+    }
+
+    SECTION("a forced redraw clears the terminal first") {
+        out.clear();
+        screen.forceFullRedraw();
+        REQUIRE(screen.present(out) == 5);
+        REQUIRE(out.rfind("\x1b[0m\x1b[2J", 0) == 0);
+    }
+}
+
+TEST_CASE("Screen scrolls a region", "[screen]") {
+    Screen screen;
+    screen.resize(10, 4);
+    screen.put(1, 1, "|");
+    for (int x = 1; x <= 3; ++x)
+        screen.put(x, 2, std::string(1, static_cast<char>('a' + x - 1)) + "bc");
+    std::string out;
+    screen.present(out);
+
+    SECTION("without hardware scrolling whole lines are scrolled and the cells beside the region repainted") {
+        screen.scroll(1, 3, 2, 4, 1);
+        REQUIRE(glyphAt(screen, 1, 1) == "|");
+        REQUIRE(glyphAt(screen, 1, 2) == "b");
+        REQUIRE(glyphAt(screen, 3, 2) == " ");
+        out.clear();
+        REQUIRE(screen.present(out) == 1);
+        REQUIRE(out.rfind("\x1b[0m\x1b[1;3r\x1b[1S\x1b[r", 0) == 0);
+        REQUIRE(out.find("?69h") == std::string::npos);
+        REQUIRE(out.find("\x1b[1;1H\x1b[0m|") != std::string::npos);
+    }
+
+    SECTION("without hardware scrolling the region is repainted when whole lines cost more") {
+        for (int x = 1; x <= 3; ++x)
+            screen.put(x, 6, std::string(5, static_cast<char>('p' + x)));
+        screen.present(out);
+        screen.scroll(1, 3, 2, 4, 1);
+        out.clear();
+        REQUIRE(screen.present(out) == 5);
+        REQUIRE(out.find('S') == std::string::npos);
+    }
+
+    SECTION("with hardware scrolling only the new line is output") {
+        screen.setHardwareScroll(true);
+        screen.scroll(1, 3, 2, 4, 1);
+        screen.put(3, 2, "dbc");
+        out.clear();
+        REQUIRE(screen.present(out) == 3);
+        REQUIRE(out.rfind("\x1b[0m\x1b[?69h\x1b[2;4s\x1b[1;3r\x1b[1S\x1b[r\x1b[?69l", 0) == 0);
+        REQUIRE(out.find("\x1b[3;2H\x1b[0mdbc") != std::string::npos);
+    }
+}
+
+TEST_CASE("Screen copies rows from another screen", "[screen]") {
+    Screen source, screen;
+    source.resize(4, 2);
+    source.put(2, 1, "a中b");
+    screen.resize(6, 3);
+    std::string out;
+    screen.present(out);
+
+    screen.blit(3, 2, source, 2);
+    REQUIRE(glyphAt(screen, 3, 2) == "a");
+    REQUIRE(glyphAt(screen, 3, 3) == "中");
+    REQUIRE(screen.at(3, 4).width == 0);
+    REQUIRE(glyphAt(screen, 3, 5) == "b");
+    out.clear();
+    REQUIRE(screen.present(out) == 3);
+
+    SECTION("copying the same row again outputs nothing") {
+        screen.blit(3, 2, source, 2);
+        out.clear();
+        REQUIRE(screen.present(out) == 0);
+    }
+
+    SECTION("the part outside the screen is cut") {
+        screen.blit(1, 4, source, 2);
+        REQUIRE(glyphAt(screen, 1, 4) == "a");
+        REQUIRE(glyphAt(screen, 1, 5) == "中");
+        REQUIRE(screen.at(1, 6).width == 0);
+    }
+}
@@ -0,0 +1,38 @@
+#include "catch.hpp"
+#include "StyleTable.h"
+
+TEST_CASE("TextStyle encodes SGR sequences", "[style]") {
+    TextStyle style;
+    REQUIRE(style.sgr() == "\x1b[0m");
+    style.fg = TextStyle::xterm(214);
+    style.bg = TextStyle::rgb(Rgb(51, 102, 255));
+    REQUIRE(style.sgr() == "\x1b[0;38;5;214;48;2;51;102;255m");
+    style = TextStyle();
+    style.fg = TextStyle::ansi(2);
+    style.bold = true;
+    REQUIRE(style.sgr() == "\x1b[0;1;32m");
+}
+
+TEST_CASE("StyleTable interns each style once", "[style]") {
+    StyleTable& table = StyleTable::getInstance();
+    REQUIRE(table.sgr(StyleTable::DEFAULT_STYLE) == "\x1b[0m");
+    REQUIRE(table.intern(TextStyle()) == StyleTable::DEFAULT_STYLE);
+
+    TextStyle style;
+    style.fg = TextStyle::rgb(Rgb(12, 34, 56));
+    StyleId id = table.intern(style);
+    REQUIRE(id != StyleTable::DEFAULT_STYLE);
+    size_t size = table.size();
+    REQUIRE(table.intern(style) == id);
+    REQUIRE(table.size() == size);
+    REQUIRE(table.get(id) == style);
+    REQUIRE(table.sgr(id) == style.sgr());
+
+    SECTION("styles that differ only in boldness or background get different ids") {
+        style.bold = true;
+        REQUIRE(table.intern(style) != id);
+        style.bold = false;
+        style.bg = style.fg;
+        REQUIRE(table.intern(style) != id);
+    }
+}
@@ -0,0 +1,77 @@
+#include "catch.hpp"
+#include "UTF8.h"
+#include <string>
+
+TEST_CASE("UTF8 computes terminal widths", "[utf8]") {
+    SECTION("single code points") {
+        REQUIRE(UTF8::codepointWidth(U'a') == 1);
+        REQUIRE(UTF8::codepointWidth(U'\n') == 0);
+        REQUIRE(UTF8::codepointWidth(U'中') == 2);
+        REQUIRE(UTF8::codepointWidth(U'，') == 2);
+        REQUIRE(UTF8::codepointWidth(U'한') == 2);
+        REQUIRE(UTF8::codepointWidth(0x1F600) == 2);
+        REQUIRE(UTF8::codepointWidth(0x0301) == 0);
+        REQUIRE(UTF8::codepointWidth(0x200D) == 0);
+        REQUIRE(UTF8::codepointWidth(0x2502) == 1);
+        REQUIRE(UTF8::codepointWidth(0xF0B1) == 1);
+        REQUIRE(UTF8::codepointWidth(0xF1302) == 1);
+    }
+
+    SECTION("strings") {
+        REQUIRE(UTF8::width("") == 0);
+        REQUIRE(UTF8::width("badminton costs 5 coins") == 23);
+        REQUIRE(UTF8::width("羽毛球 5 金币") == 13);
+        REQUIRE(UTF8::width("e\xCC\x81") == 1);
+        REQUIRE(UTF8::width("\U000f1302 home") == 6);
+        // 非法序列按一个替换字符计算
+        REQUIRE(UTF8::width("a\xFF" "b") == 3);
+        REQUIRE(UTF8::width("abc\xE4\xB8") == 5);
+    }
+
+    SECTION("padding") {
+        REQUIRE(UTF8::padding("面包", 6) == "  ");
+        REQUIRE(UTF8::padding("bread", 6) == " ");
+        REQUIRE(UTF8::padding("很长的商品名称", 6).empty());
+    }
+}
+
+TEST_CASE("UTF8 cuts text by display width", "[utf8]") {
+    std::string text = "abcdefghij中文klm";
+    size_t index = 0;
+
+    SECTION("ascii runs are cut exactly") {
+        REQUIRE(UTF8::cut(text, index, 4) == 4);
+        REQUIRE(index == 4);
+    }
+
+    SECTION("a wide character that does not fit starts the next piece") {
+        REQUIRE(UTF8::cut(text, index, 11) == 10);
+        REQUIRE(index == 10);
+        REQUIRE(UTF8::cut(text, index, 3) == 2);
+        REQUIRE(text.substr(10, index - 10) == "中");
+        REQUIRE(UTF8::cut(text, index, 5) == 5);
+        REQUIRE(text.substr(13, index - 13) == "文klm");
+        REQUIRE(index == text.size());
+    }
+
+    SECTION("at least one character is taken") {
+        index = 10;
+        REQUIRE(UTF8::cut(text, index, 1) == 2);
+        REQUIRE(index == 13);
+        index = 0;
+        REQUIRE(UTF8::cut(text, index, 0) == 1);
+        REQUIRE(index == 1);
+    }
+
+    SECTION("splitting never breaks a character") {
+        std::string mixed;
+        for (int i = 0; i < 20; ++i)
+            mixed += "参加羽毛球 (badminton) ";
+        std::string joined;
+        for (size_t start = 0, pos = 0; pos < mixed.size(); start = pos) {
+            REQUIRE(UTF8::cut(mixed, pos, 7) <= 7);
+            joined += mixed.substr(start, pos - start);
+        }
+        REQUIRE(joined == mixed);
+    }
+}
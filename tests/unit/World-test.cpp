@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "Controller.h"
+#include "Map.h"
+#include "MapPrefetcher.h"
+#include "Scene.h"
+#include "World.h"
+
+namespace {
+    std::filesystem::path sceneFile() {
+        return Controller::getInstance()->getRootDir() / ".config" / "scenes.json";
+    }
+}
+
+TEST_CASE("World loads each scene once", "[world]") {
+    World world(sceneFile());
+    auto center = world.getScene("Center");
+    REQUIRE(center == world.getScene("Center"));
+    REQUIRE(world.cachedScenes() == 1);
+
+    // 与直接读取文件得到的出口一致
+    Scene from_file("Center");
+    REQUIRE(center->name == "Center");
+    REQUIRE(center->exits == from_file.exits);
+    REQUIRE(center->getSceneName(1) == "Canteen");
+
+    REQUIRE(world.getScene("Canteen")->exits == Scene("Canteen").exits);
+    REQUIRE(world.cachedScenes() == 2);
+
+    // 未知场景没有出口
+    REQUIRE(world.getScene("Nowhere")->exits.empty());
+}
+
+TEST_CASE("World reuses maps and resets the protagonist", "[world]") {
+    World world(sceneFile());
+    auto center = world.getMap("Center.txt");
+    REQUIRE(center->valid());
+    Position spawn = center->getPos();
+    REQUIRE(spawn == Map("Center.txt").getPos());
+
+    // 走几步再离开
+    EventType event = EventType::NONE;
+    int id = -1;
+    int direction = center->moveProtagonist(1, event, id).status == 0 ? 1 : 3;
+    if (direction == 3)
+        REQUIRE(center->moveProtagonist(3, event, id).status == 0);
+    REQUIRE(center->getPos() != spawn);
+    Position moved = center->getPos();
+
+    auto canteen = world.getMap("Canteen.txt");
+    REQUIRE(canteen != center);
+    REQUIRE(world.cachedMaps() == 2);
+
+    SECTION("coming back returns the same map at the spawn point") {
+        auto again = world.getMap("Center.txt");
+        REQUIRE(again == center);
+        REQUIRE(again->getPos() == spawn);
+        // 离开的位置不再有主角，可以重新走过去
+        REQUIRE(again->detectCollision(moved) == -1);
+        REQUIRE(again->moveProtagonist(direction, event, id).status == 0);
+        REQUIRE(again->getPos() == moved);
+    }
+
+    SECTION("an explicit position overrides the spawn point") {
+        auto again = world.getMap("Center.txt", moved);
+        REQUIRE(again->getPos() == moved);
+    }
+
+    SECTION("clear drops every cached object") {
+        world.clear();
+        REQUIRE(world.cachedMaps() == 0);
+        REQUIRE(world.cachedScenes() == 0);
+        REQUIRE(world.getMap("Center.txt") != center);
+    }
+}
+
+TEST_CASE("World does not cache invalid maps", "[world]") {
+    World world(sceneFile());
+    auto missing = world.getMap("no_such_map.txt");
+    REQUIRE_FALSE(missing->valid());
+    REQUIRE(world.cachedMaps() == 0);
+    REQUIRE(world.getMap("no_such_map.txt") != missing);
+}
+
+TEST_CASE("World prefetches neighbouring maps in the background", "[world]") {
+    World world(sceneFile(), true);
+    auto center = world.getMap("Center.txt");
+    size_t submitted = world.prefetchNeighbours("Center");
+    REQUIRE(submitted == world.getScene("Center")->exits.size());
+    // 已经提交的地图不会重复提交
+    REQUIRE(world.prefetchNeighbours("Center") == 0);
+
+    world.waitPrefetch();
+    REQUIRE(world.cachedMaps() == 1 + submitted);
+    for (const auto& [id, name] : world.getScene("Center")->exits) {
+        INFO(name);
+        auto map = world.getMap(name + ".txt");
+        REQUIRE(map->valid());
+        REQUIRE(map->getPos() == Map(name + ".txt").getPos());
+    }
+    REQUIRE(world.cachedMaps() == 1 + submitted);
+    REQUIRE(world.getMap("Center.txt") == center);
+
+    // 相邻场景已经全部缓存
+    REQUIRE(world.prefetchNeighbours("Center") == 0);
+}
+
+TEST_CASE("World without prefetch only builds neighbouring scenes", "[world]") {
+    World world(sceneFile());
+    REQUIRE(world.prefetchNeighbours("Center") == 0);
+    world.waitPrefetch();
+    REQUIRE(world.cachedMaps() == 0);
+    REQUIRE(world.cachedScenes() == 1 + world.getScene("Center")->exits.size());
+}
+
+TEST_CASE("Map prefetcher reports results it had to drop", "[world]") {
+    MapPrefetcher prefetcher(2);
+    const std::vector<std::string> names = {"Center.txt", "Canteen.txt", "Library.txt"};
+    for (const auto& name : names) {
+        REQUIRE(prefetcher.request(name));
+        prefetcher.wait();
+    }
+    // 结果队列只能放两张地图，第三张被丢弃
+    REQUIRE(prefetcher.takeDropped() == std::vector<std::string>{"Library.txt"});
+    REQUIRE(prefetcher.takeDropped().empty());
+    MapPrefetcher::Loaded loaded;
+    REQUIRE(prefetcher.tryTake(loaded));
+    REQUIRE(loaded.filename == "Center.txt");
+}